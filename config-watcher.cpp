@@ -0,0 +1,152 @@
+#include "config-watcher.hpp"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <phosphor-logging/lg2.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+namespace phosphor
+{
+namespace led
+{
+
+ConfigWatcher::ConfigWatcher(const sdeventplus::Event& event,
+                             const fs::path& confFile,
+                             const fs::path& overrideFile,
+                             std::function<void(const fs::path&)> callBack) :
+    confFile(confFile),
+    overrideFile(overrideFile), callBack(std::move(callBack))
+{
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        lg2::error("Failed to initialize inotify, ERROR = {ERROR}", "ERROR",
+                   strerror(errno));
+        return;
+    }
+
+    // Watch the directory, editors replace the file rather than rewriting
+    // it in place.
+    confWatch = addWatch(confFile.parent_path(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (confFile != overrideFile)
+    {
+        watchOverride();
+    }
+
+    io.emplace(event, fd, EPOLLIN,
+               [this](sdeventplus::source::IO&, int, uint32_t) {
+        handleEvents();
+    });
+}
+
+int ConfigWatcher::addWatch(const fs::path& dir, uint32_t mask)
+{
+    auto wd = inotify_add_watch(fd, dir.c_str(), mask);
+    if (wd < 0)
+    {
+        lg2::error(
+            "Failed to watch LED config directory, FILE_PATH = {PATH}, ERROR = {ERROR}",
+            "PATH", dir, "ERROR", strerror(errno));
+    }
+    return wd;
+}
+
+void ConfigWatcher::watchOverride()
+{
+    std::error_code ec;
+    auto dir = overrideFile.parent_path();
+    if (fs::is_directory(dir, ec))
+    {
+        overrideWatch = addWatch(dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+        return;
+    }
+
+    overrideParentWatch =
+        addWatch(dir.parent_path(), IN_CREATE | IN_MOVED_TO | IN_ONLYDIR);
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    io.reset();
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+void ConfigWatcher::handleEvents()
+{
+    alignas(inotify_event) std::array<char, 4096> buffer;
+    bool changed = false;
+    bool overrideAdded = false;
+
+    while (true)
+    {
+        auto size = read(fd, buffer.data(), buffer.size());
+        if (size <= 0)
+        {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < size;)
+        {
+            const auto* event =
+                reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->len == 0)
+            {
+                continue;
+            }
+
+            if (event->wd == confWatch && confFile.filename() == event->name)
+            {
+                changed = true;
+            }
+            else if (event->wd == overrideWatch &&
+                     overrideFile.filename() == event->name)
+            {
+                overrideAdded = true;
+            }
+            else if (event->wd == overrideParentWatch &&
+                     overrideFile.parent_path().filename() == event->name)
+            {
+                // The directory may already hold the config when watched
+                inotify_rm_watch(fd, overrideParentWatch);
+                overrideParentWatch = -1;
+                watchOverride();
+
+                std::error_code ec;
+                overrideAdded = fs::exists(overrideFile, ec);
+            }
+        }
+    }
+
+    if (overrideAdded)
+    {
+        // The override config is selected over the one in use, only it
+        // matters from now on.
+        lg2::info("LED override config added, FILE_PATH = {PATH}", "PATH",
+                  overrideFile);
+        if (confWatch >= 0 && confWatch != overrideWatch)
+        {
+            inotify_rm_watch(fd, confWatch);
+        }
+        confFile = overrideFile;
+        confWatch = overrideWatch;
+        overrideWatch = -1;
+        changed = true;
+    }
+
+    if (changed)
+    {
+        lg2::info("LED config changed, FILE_PATH = {PATH}", "PATH", confFile);
+        callBack(confFile);
+    }
+}
+
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/io.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+
+namespace phosphor
+{
+namespace led
+{
+
+namespace fs = std::filesystem;
+
+/** @class ConfigWatcher
+ *  @brief Watches the LED config file with inotify and reports when it
+ *         has been rewritten or replaced. The override config, which is
+ *         selected over any other config, is watched as well and reported
+ *         once it shows up. It is the config watched from then on.
+ */
+class ConfigWatcher
+{
+  public:
+    ConfigWatcher() = delete;
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+    ConfigWatcher(ConfigWatcher&&) = delete;
+    ConfigWatcher& operator=(ConfigWatcher&&) = delete;
+
+    /** @brief Starts watching the config file. Failing to do so is logged
+     *         and the file is not watched.
+     *
+     *  @param[in] event        - sd event handler
+     *  @param[in] confFile     - path of the LED config
+     *  @param[in] overrideFile - path of the override LED config
+     *  @param[in] callBack     - called with the path once the config
+     *                            changed
+     */
+    ConfigWatcher(const sdeventplus::Event& event, const fs::path& confFile,
+                  const fs::path& overrideFile,
+                  std::function<void(const fs::path&)> callBack);
+
+    ~ConfigWatcher();
+
+  private:
+    /** @brief Reads the pending inotify events, reporting the config file
+     *         once when any of them is about it
+     */
+    void handleEvents();
+
+    /** @brief Adds an inotify watch on a directory, logging a failure
+     *
+     *  @param[in] dir  - directory to watch
+     *  @param[in] mask - inotify events to watch
+     *
+     *  @return the watch descriptor, -1 on failure
+     */
+    int addWatch(const fs::path& dir, uint32_t mask);
+
+    /** @brief Watches the override config directory, or its parent until
+     *         the directory is created
+     */
+    void watchOverride();
+
+    /** @brief path of the LED config */
+    fs::path confFile;
+
+    /** @brief path of the override LED config */
+    fs::path overrideFile;
+
+    /** @brief watch descriptor of the LED config directory */
+    int confWatch{-1};
+
+    /** @brief watch descriptor of the override config directory */
+    int overrideWatch{-1};
+
+    /** @brief watch descriptor of the parent of the override config
+     *         directory, while that directory does not exist
+     */
+    int overrideParentWatch{-1};
+
+    /** @brief called once the config changed */
+    std::function<void(const fs::path&)> callBack;
+
+    /** @brief inotify file descriptor */
+    int fd{-1};
+
+    /** @brief event source of the inotify file descriptor */
+    std::optional<sdeventplus::source::IO> io;
+};
+
+} // namespace led
+} // namespace phosphor
@@ -8,6 +8,9 @@
 #include <xyz/openbmc_project/Led/Fru/Monitor/error.hpp>
 #include <xyz/openbmc_project/Led/Mapper/error.hpp>
 
+#include <cerrno>
+#include <chrono>
+
 namespace phosphor
 {
 namespace led
@@ -42,14 +45,17 @@ using Path = std::string;
 using Interface = std::string;
 using Interfaces = std::vector<Interface>;
 using MapperResponseType = std::map<Path, std::map<Service, Interfaces>>;
+using ManagedObjectType =
+    std::map<sdbusplus::message::object_path, InterfaceMap>;
 
-using MethodErr =
-    sdbusplus::xyz::openbmc_project::Led::Mapper::Error::MethodError;
 using ObjectNotFoundErr =
     sdbusplus::xyz::openbmc_project::Led::Mapper::Error::ObjectNotFoundError;
 using InventoryPathErr = sdbusplus::xyz::openbmc_project::Led::Fru::Monitor::
     Error::InventoryPathError;
 
+/** @brief Bound of the LED group calls pending at once */
+constexpr size_t MAX_PENDING_ACTIONS = 16;
+
 std::string getService(sdbusplus::bus::bus& bus, const std::string& path)
 {
     auto mapper = bus.new_method_call(MAPPER_BUSNAME, MAPPER_OBJ_PATH,
@@ -83,38 +89,130 @@ std::string getService(sdbusplus::bus::bus& bus, const std::string& path)
     return mapperResponse.cbegin()->first;
 }
 
-void action(sdbusplus::bus::bus& bus, const std::string& path, bool assert)
+void Add::action(const std::string& path, bool assert)
 {
-    std::string service;
-    try
+    auto pos = path.rfind("/");
+    if (pos == std::string::npos)
     {
-        std::string groups{LED_GROUPS};
-        groups.pop_back();
-        service = getService(bus, groups);
+        using namespace xyz::openbmc_project::Led::Fru::Monitor;
+        report<InventoryPathErr>(InventoryPathError::PATH(path.c_str()));
+        return;
     }
-    catch (const MethodErr& e)
+
+    // A newer state of the FRU replaces the one still waiting
+    queuedActions[path] = assert;
+    queueEvent.set_enabled(sdeventplus::source::Enabled::OneShot);
+}
+
+void Add::processQueue()
+{
+    queueEvent.set_enabled(sdeventplus::source::Enabled::Off);
+
+    // Calls completed since the last run can be released now that we are
+    // out of their reply callbacks.
+    completedSlots.clear();
+
+    if (groupsService.empty())
     {
-        commit<MethodErr>();
+        lookupService();
         return;
     }
-    catch (const ObjectNotFoundErr& e)
+
+    auto iter = queuedActions.begin();
+    while (iter != queuedActions.end() &&
+           pendingActions.size() < MAX_PENDING_ACTIONS)
+    {
+        // The states of a FRU are set in order, one call at a time
+        if (pendingActions.contains(iter->first))
+        {
+            ++iter;
+            continue;
+        }
+
+        auto [path, assert] = *iter;
+        iter = queuedActions.erase(iter);
+        sendAction(path, assert);
+    }
+}
+
+void Add::lookupService()
+{
+    if (serviceLookup)
     {
-        commit<ObjectNotFoundErr>();
         return;
     }
 
-    auto pos = path.rfind("/");
-    if (pos == std::string::npos)
+    std::string groups{LED_GROUPS};
+    groups.pop_back();
+
+    auto mapper = bus.new_method_call(MAPPER_BUSNAME, MAPPER_OBJ_PATH,
+                                      MAPPER_IFACE, "GetObject");
+    mapper.append(groups.c_str(), std::vector<std::string>({OBJMGR_IFACE}));
+
+    try
     {
-        using namespace xyz::openbmc_project::Led::Fru::Monitor;
-        report<InventoryPathErr>(InventoryPathError::PATH(path.c_str()));
+        serviceLookup = bus.call_async(
+            mapper, [this](sdbusplus::message_t reply) {
+                serviceReplyHandler(reply);
+            });
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        lg2::error("Failed to call getService mapper, ERROR = {ERROR}",
+                   "ERROR", e);
+
+        // The LED groups can not be set without their service
+        queuedActions.clear();
+    }
+}
+
+void Add::serviceReplyHandler(sdbusplus::message_t& reply)
+{
+    completedSlots.emplace_back(std::move(*serviceLookup));
+    serviceLookup.reset();
+
+    std::map<std::string, std::vector<std::string>> mapperResponse;
+    try
+    {
+        if (!reply.is_method_error())
+        {
+            reply.read(mapperResponse);
+        }
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        lg2::error(
+            "Failed to parse getService mapper response, ERROR = {ERROR}",
+            "ERROR", e);
+    }
+
+    if (mapperResponse.empty())
+    {
+        std::string groups{LED_GROUPS};
+        groups.pop_back();
+
+        using namespace xyz::openbmc_project::Led::Mapper;
+        report<ObjectNotFoundErr>(
+            ObjectNotFoundError::METHOD_NAME("GetObject"),
+            ObjectNotFoundError::PATH(groups.c_str()),
+            ObjectNotFoundError::INTERFACE(OBJMGR_IFACE));
+
+        // The LED groups can not be set without their service
+        queuedActions.clear();
         return;
     }
-    auto unit = path.substr(pos + 1);
+
+    groupsService = mapperResponse.cbegin()->first;
+    queueEvent.set_enabled(sdeventplus::source::Enabled::OneShot);
+}
+
+void Add::sendAction(const std::string& path, bool assert)
+{
+    auto unit = path.substr(path.rfind("/") + 1);
 
     std::string ledPath = LED_GROUPS + unit + '_' + LED_FAULT;
 
-    auto method = bus.new_method_call(service.c_str(), ledPath.c_str(),
+    auto method = bus.new_method_call(groupsService.c_str(), ledPath.c_str(),
                                       "org.freedesktop.DBus.Properties", "Set");
     method.append("xyz.openbmc_project.Led.Group");
     method.append("Asserted");
@@ -123,21 +221,50 @@ void action(sdbusplus::bus::bus& bus, const std::string& path, bool assert)
 
     try
     {
-        bus.call_noreply(method);
+        pendingActions.emplace(
+            path, bus.call_async(method,
+                                 [this, path](sdbusplus::message_t reply) {
+            actionReplyHandler(path, reply);
+        }));
     }
     catch (const sdbusplus::exception::exception& e)
     {
+        lg2::error("Failed to Assert LED Group, ERROR = {ERROR}", "ERROR", e);
+    }
+}
+
+void Add::actionReplyHandler(const std::string& path,
+                             sdbusplus::message_t& reply)
+{
+    auto pending = pendingActions.find(path);
+    if (pending != pendingActions.end())
+    {
+        completedSlots.emplace_back(std::move(pending->second));
+        pendingActions.erase(pending);
+    }
+
+    if (reply.is_method_error())
+    {
+        // A ServiceUnknown error, find the service again next time
+        if (reply.get_errno() == EHOSTUNREACH)
+        {
+            groupsService.clear();
+        }
+
         // Log an info message, system may not have all the LED Groups defined
-        lg2::info("Failed to Assert LED Group, ERROR = {ERROR}", "ERROR", e);
+        lg2::info(
+            "Failed to Assert LED Group, ERRNO = {ERRNO}, INVENTORY_PATH = {PATH}",
+            "ERRNO", reply.get_errno(), "PATH", path);
     }
 
-    return;
+    if (!queuedActions.empty())
+    {
+        queueEvent.set_enabled(sdeventplus::source::Enabled::OneShot);
+    }
 }
 
 void Add::created(sdbusplus::message::message& msg)
 {
-    auto bus = msg.get_bus();
-
     sdbusplus::message::object_path objectPath;
     InterfaceMap interfaces;
     try
@@ -186,9 +313,7 @@ void Add::created(sdbusplus::message::message& msg)
     {
         if (std::get<1>(item).compare(CALLOUT_REV_ASSOCIATION) == 0)
         {
-            removeWatches.emplace_back(
-                std::make_unique<Remove>(bus, std::get<2>(item)));
-            action(bus, std::get<2>(item), true);
+            addCallout(objectPath.str, std::get<2>(item));
         }
     }
 
@@ -218,6 +343,81 @@ void getLoggingSubTree(sdbusplus::bus::bus& bus, MapperResponseType& subtree)
 }
 
 void Add::processExistingCallouts(sdbusplus::bus::bus& bus)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    if (!processManagedCallouts(bus))
+    {
+        processSubTreeCallouts(bus);
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    lg2::info(
+        "Processed the existing callouts, COUNT = {COUNT}, DURATION_MS = {DURATION}",
+        "COUNT", callouts.size(), "DURATION", duration.count());
+}
+
+bool Add::processManagedCallouts(sdbusplus::bus::bus& bus)
+{
+    ManagedObjectType objects;
+    try
+    {
+        auto service = getService(bus, LOG_PATH);
+        auto method = bus.new_method_call(service.c_str(), LOG_PATH,
+                                          OBJMGR_IFACE, "GetManagedObjects");
+
+        // The properties of other types read as the default bool
+        auto reply = bus.call(method);
+        reply.read(objects);
+    }
+    catch (const std::exception& e)
+    {
+        lg2::info(
+            "Failed to get the error log entries, falling back to the mapper, ERROR = {ERROR}",
+            "ERROR", e);
+        return false;
+    }
+
+    for (const auto& [objectPath, interfaces] : objects)
+    {
+        if (objectPath.str.find(ELOG_ENTRY) == std::string::npos)
+        {
+            continue;
+        }
+
+        auto iter =
+            interfaces.find("xyz.openbmc_project.Association.Definitions");
+        if (iter == interfaces.end())
+        {
+            continue;
+        }
+
+        auto attr = iter->second.find("Associations");
+        if (attr == iter->second.end())
+        {
+            continue;
+        }
+
+        const auto* assocs = std::get_if<AssociationList>(&attr->second);
+        if (!assocs)
+        {
+            continue;
+        }
+
+        for (const auto& item : *assocs)
+        {
+            if (std::get<1>(item).compare(CALLOUT_REV_ASSOCIATION) == 0)
+            {
+                addCallout(objectPath.str, std::get<2>(item));
+            }
+        }
+    }
+
+    return true;
+}
+
+void Add::processSubTreeCallouts(sdbusplus::bus::bus& bus)
 {
     MapperResponseType mapperResponse;
 
@@ -266,19 +466,57 @@ void Add::processExistingCallouts(sdbusplus::bus::bus& bus)
         {
             if (std::get<1>(item).compare(CALLOUT_REV_ASSOCIATION) == 0)
             {
-                removeWatches.emplace_back(
-                    std::make_unique<Remove>(bus, std::get<2>(item)));
-                action(bus, std::get<2>(item), true);
+                addCallout(elem.first, std::get<2>(item));
             }
         }
     }
 }
 
-void Remove::removed(sdbusplus::message::message& msg)
+void Add::addCallout(const std::string& logPath,
+                     const std::string& inventoryPath)
 {
-    auto bus = msg.get_bus();
+    // An entry created while the existing ones are processed is seen twice
+    if (callouts[logPath].insert(inventoryPath).second &&
+        ++faultCounts[inventoryPath] == 1)
+    {
+        action(inventoryPath, true);
+    }
+}
 
-    action(bus, inventoryPath, false);
+void Add::removed(sdbusplus::message::message& msg)
+{
+    sdbusplus::message::object_path objectPath;
+    std::vector<std::string> interfaces;
+    try
+    {
+        msg.read(objectPath, interfaces);
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        lg2::error("Failed to parse removed message, ERROR = {ERROR}", "ERROR",
+                   e);
+        return;
+    }
+
+    auto entry = callouts.find(objectPath.str);
+    if (entry == callouts.end())
+    {
+        // Not an error entry calling out a FRU
+        return;
+    }
+
+    auto inventoryPaths = std::move(entry->second);
+    callouts.erase(entry);
+    for (const auto& inventoryPath : inventoryPaths)
+    {
+        // Other entries may still call out the FRU
+        auto count = faultCounts.find(inventoryPath);
+        if (count != faultCounts.end() && --count->second == 0)
+        {
+            faultCounts.erase(count);
+            action(inventoryPath, false);
+        }
+    }
     return;
 }
 
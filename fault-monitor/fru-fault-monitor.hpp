@@ -4,8 +4,15 @@
 
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/event.hpp>
 
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <set>
 #include <string>
+#include <vector>
 
 namespace phosphor
 {
@@ -18,19 +25,11 @@ namespace fault
 namespace monitor
 {
 
-/** @brief Assert or deassert an LED based on the input FRU
- *  @param[in] bus       -  The Dbus bus object
- *  @param[in] path      -  Inventory path of the FRU
- *  @param[in] assert    -  Assert if true deassert if false
- */
-void action(sdbusplus::bus::bus& bus, const std::string& path, bool assert);
-
-class Remove;
-
 /** @class Add
  *  @brief Implementation of LED handling during FRU fault
  *  @details This implements methods for watching for a FRU fault
- *  being logged to assert the corresponding LED
+ *  being logged to assert the corresponding LED. The LED groups are set
+ *  with asynchronous calls, from a queue processed by the event loop.
  */
 class Add
 {
@@ -43,89 +42,139 @@ class Add
     Add& operator=(Add&&) = default;
 
     /** @brief constructs Add a watch for FRU faults.
-     *  @param[in] bus -  The Dbus bus object
+     *  @param[in] bus   -  The Dbus bus object
+     *  @param[in] event -  The event loop processing the LED group calls
      */
-    Add(sdbusplus::bus::bus& bus) :
+    Add(sdbusplus::bus::bus& bus, const sdeventplus::Event& event) :
+        bus(bus),
+        queueEvent(event, [this](auto&) { processQueue(); }),
         matchCreated(
             bus,
             sdbusplus::bus::match::rules::interfacesAdded() +
                 sdbusplus::bus::match::rules::path_namespace(
                     "/xyz/openbmc_project/logging"),
-            std::bind(std::mem_fn(&Add::created), this, std::placeholders::_1))
+            std::bind(std::mem_fn(&Add::created), this, std::placeholders::_1)),
+        matchRemoved(
+            bus,
+            sdbusplus::bus::match::rules::interfacesRemoved() +
+                sdbusplus::bus::match::rules::path_namespace(
+                    "/xyz/openbmc_project/logging"),
+            std::bind(std::mem_fn(&Add::removed), this, std::placeholders::_1))
     {
+        queueEvent.set_enabled(sdeventplus::source::Enabled::Off);
+
         processExistingCallouts(bus);
     }
 
   private:
+    /** @brief sdbusplus D-Bus connection. */
+    sdbusplus::bus::bus& bus;
+
+    /** @brief Inventory paths called out, keyed by error log entry path */
+    std::map<std::string, std::set<std::string>> callouts;
+
+    /** @brief Number of open error log entries calling out each FRU, keyed
+     *         by inventory path */
+    std::map<std::string, size_t> faultCounts;
+
+    /** @brief Service of the LED groups, empty until found */
+    std::string groupsService;
+
+    /** @brief LED states waiting to be set, keyed by inventory path. A newer
+     *         state of a FRU replaces the one still waiting, so the queue
+     *         never holds more than one entry per FRU.
+     */
+    std::map<std::string, bool> queuedActions;
+
+    /** @brief Pending LED group calls, keyed by inventory path */
+    std::map<std::string, sdbusplus::slot_t> pendingActions;
+
+    /** @brief Pending lookup of the LED groups service */
+    std::optional<sdbusplus::slot_t> serviceLookup;
+
+    /** @brief Slots of the completed calls. A slot can not be destroyed from
+     *         its own reply callback, so they are released on the next run
+     *         of the queue.
+     */
+    std::vector<sdbusplus::slot_t> completedSlots;
+
+    /** @brief Deferred event processing the queued LED states */
+    sdeventplus::source::Defer queueEvent;
+
     /** @brief sdbusplus signal match for fault created */
     sdbusplus::bus::match_t matchCreated;
 
-    std::vector<std::unique_ptr<Remove>> removeWatches;
+    /** @brief sdbusplus signal match for fault removed, shared by all the
+     *         error log entries */
+    sdbusplus::bus::match_t matchRemoved;
 
-    /** @brief Callback function for fru fault created
-     *  @param[in] msg       - Data associated with subscribed signal
+    /** @brief Queue the assert or deassert of an LED based on the input FRU
+     *  @param[in] path      -  Inventory path of the FRU
+     *  @param[in] assert    -  Assert if true deassert if false
      */
-    void created(sdbusplus::message::message& msg);
+    void action(const std::string& path, bool assert);
 
-    /** @brief This function process all callouts at application start
-     *  @param[in] bus - The Dbus bus object
+    /** @brief Sends the queued LED states, up to a bound of pending calls.
+     *         The LED groups service is looked up first when not known.
      */
-    void processExistingCallouts(sdbusplus::bus::bus& bus);
-};
+    void processQueue();
 
-/** @class Remove
- *  @brief Implementation of LED handling after resolution of FRU fault
- *  @details Implement methods for watching the resolution of FRU faults
- *  and deasserting corresponding LED.
- */
-class Remove
-{
-  public:
-    Remove() = delete;
-    ~Remove() = default;
-    Remove(const Remove&) = delete;
-    Remove& operator=(const Remove&) = delete;
-    Remove(Remove&&) = default;
-    Remove& operator=(Remove&&) = default;
-
-    /** @brief constructs Remove
-     *  @param[in] bus  -  The Dbus bus object
-     *  @param[in] path -  Inventory path to fru
+    /** @brief Looks up the LED groups service with the mapper */
+    void lookupService();
+
+    /** @brief Handles the reply of the LED groups service lookup
+     *  @param[in] reply - Reply of the mapper
      */
-    Remove(sdbusplus::bus::bus& bus, const std::string& path) :
-        inventoryPath(path),
-        matchRemoved(bus, match(path),
-                     std::bind(std::mem_fn(&Remove::removed), this,
-                               std::placeholders::_1))
-    {
-        // Do nothing
-    }
+    void serviceReplyHandler(sdbusplus::message_t& reply);
 
-  private:
-    /** @brief inventory path of the FRU */
-    std::string inventoryPath;
+    /** @brief Sets the Asserted property of the fault LED group of a FRU
+     *  @param[in] path      -  Inventory path of the FRU
+     *  @param[in] assert    -  Assert if true deassert if false
+     */
+    void sendAction(const std::string& path, bool assert);
 
-    /** @brief sdbusplus signal matches for fault removed */
-    sdbusplus::bus::match_t matchRemoved;
+    /** @brief Handles the reply of an LED group call
+     *  @param[in] path  - Inventory path of the FRU
+     *  @param[in] reply - Reply of the LED groups service
+     */
+    void actionReplyHandler(const std::string& path,
+                            sdbusplus::message_t& reply);
 
     /** @brief Callback function for fru fault created
      *  @param[in] msg       - Data associated with subscribed signal
      */
+    void created(sdbusplus::message::message& msg);
+
+    /** @brief Callback function for fru fault removed
+     *  @param[in] msg       - Data associated with subscribed signal
+     */
     void removed(sdbusplus::message::message& msg);
 
-    /** @brief function to create fault remove match for a fru
-     *  @param[in] path  - Inventory path of the faulty unit.
+    /** @brief Records a FRU called out by an error log entry, unless already
+     *         recorded. Its LED is asserted by the first entry calling it out.
+     *  @param[in] logPath       - Path of the error log entry
+     *  @param[in] inventoryPath - Inventory path of the FRU
      */
-    std::string match(const std::string& path)
-    {
-        namespace MatchRules = sdbusplus::bus::match::rules;
+    void addCallout(const std::string& logPath,
+                    const std::string& inventoryPath);
+
+    /** @brief This function process all callouts at application start
+     *  @param[in] bus - The Dbus bus object
+     */
+    void processExistingCallouts(sdbusplus::bus::bus& bus);
 
-        std::string matchStmt =
-            MatchRules::interfacesRemoved() +
-            MatchRules::argNpath(0, path + "/" + CALLOUT_REV_ASSOCIATION);
+    /** @brief Processes the callouts of all the error log entries, got at
+     *         once from the logging service object manager
+     *  @param[in] bus - The Dbus bus object
+     *  @return false if the entries could not be got
+     */
+    bool processManagedCallouts(sdbusplus::bus::bus& bus);
 
-        return matchStmt;
-    }
+    /** @brief Processes the callouts of the error log entries found by the
+     *         mapper, getting the associations of each entry
+     *  @param[in] bus - The Dbus bus object
+     */
+    void processSubTreeCallouts(sdbusplus::bus::bus& bus);
 };
 } // namespace monitor
 } // namespace fault
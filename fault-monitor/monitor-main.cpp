@@ -6,22 +6,27 @@
 #include "fru-fault-monitor.hpp"
 #endif
 
+#include <sdeventplus/event.hpp>
+
 int main(void)
 {
-    /** @brief Dbus constructs used by Fault Monitor */
-    sdbusplus::bus::bus bus = sdbusplus::bus::new_default();
+    /** @brief Event loop dispatching the signals and the call replies */
+    auto event = sdeventplus::Event::get_default();
 
 #ifdef MONITOR_OPERATIONAL_STATUS
+    /** @brief Dbus constructs used by Fault Monitor, shared with DBusHandler
+     *         so that its service cache sees the invalidation signals */
+    auto& bus = phosphor::led::utils::DBusHandler::getBus();
+
     phosphor::led::Operational::status::monitor::Monitor monitor(bus);
 #else
-    phosphor::led::fru::fault::monitor::Add monitor(bus);
+    /** @brief Dbus constructs used by Fault Monitor */
+    sdbusplus::bus::bus bus = sdbusplus::bus::new_default();
+
+    phosphor::led::fru::fault::monitor::Add monitor(bus, event);
 #endif
-    /** @brief Wait for client requests */
-    while (true)
-    {
-        /** @brief process dbus calls / signals discarding unhandled */
-        bus.process_discard();
-        bus.wait();
-    }
-    return 0;
+    /** @brief Attach the bus to sd_event to service the signals */
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+
+    return event.loop();
 }
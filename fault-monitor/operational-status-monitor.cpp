@@ -9,6 +9,9 @@
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/lg2.hpp>
 
+#include <algorithm>
+#include <string_view>
+
 namespace phosphor
 {
 namespace led
@@ -19,8 +22,19 @@ namespace status
 {
 namespace monitor
 {
+constexpr auto ASSOCIATION_IFACE = "xyz.openbmc_project.Association";
+constexpr std::string_view FAULT_LED_ASSOCIATION = "/fault_led_group";
+constexpr auto CHASSIS_CRITICAL_ASSOCIATION =
+    "/xyz/openbmc_project/inventory/system/chassis/critical";
+
 void Monitor::removeCriticalAssociation(const std::string& objectPath)
 {
+    // The chassis critical association lists the objects holding it
+    if (associationsLoaded && !criticalPaths.contains(objectPath))
+    {
+        return;
+    }
+
     try
     {
         PropertyValue getAssociationValue = dBusHandler.getProperty(
@@ -111,8 +125,18 @@ void Monitor::matchHandler(sdbusplus::message::message& msg)
 }
 
 const std::vector<std::string>
-    Monitor::getLedGroupPaths(const std::string& inventoryPath) const
+    Monitor::getLedGroupPaths(const std::string& inventoryPath)
 {
+    auto cached = ledGroups.find(inventoryPath);
+    if (cached != ledGroups.end())
+    {
+        return cached->second;
+    }
+    if (associationsLoaded)
+    {
+        return {};
+    }
+
     // Get endpoints from the rType
     std::string faultLedAssociation = inventoryPath + "/fault_led_group";
 
@@ -136,9 +160,165 @@ const std::vector<std::string>
         return {};
     }
 
-    auto& endpoints = std::get<std::vector<std::string>>(endpoint);
+    const auto* endpoints = std::get_if<std::vector<std::string>>(&endpoint);
+    if (!endpoints)
+    {
+        return {};
+    }
+
+    return *endpoints;
+}
+
+void Monitor::loadAssociations()
+{
+    ManagedObjects objects;
+    try
+    {
+        objects = dBusHandler.getManagedObjects(MAPPER_BUSNAME, "/");
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        // Look up the associations of each inventory object instead
+        lg2::error("Failed to load the associations, ERROR = {ERROR}", "ERROR",
+                   e);
+        return;
+    }
+
+    for (const auto& [path, interfaces] : objects)
+    {
+        auto interface = interfaces.find(ASSOCIATION_IFACE);
+        if (interface == interfaces.end())
+        {
+            continue;
+        }
+
+        auto property = interface->second.find("endpoints");
+        if (property == interface->second.end())
+        {
+            continue;
+        }
+
+        if (const auto* endpoints =
+                std::get_if<std::vector<std::string>>(&property->second))
+        {
+            updateAssociation(path.str, *endpoints);
+        }
+    }
+
+    associationsLoaded = true;
+    lg2::info(
+        "Loaded the associations, LED_GROUPS = {LED_GROUPS}, CRITICAL = {CRITICAL}",
+        "LED_GROUPS", ledGroups.size(), "CRITICAL", criticalPaths.size());
+}
+
+void Monitor::updateAssociation(const std::string& path,
+                                const std::vector<std::string>& endpoints)
+{
+    if (path == CHASSIS_CRITICAL_ASSOCIATION)
+    {
+        criticalPaths = {endpoints.begin(), endpoints.end()};
+        return;
+    }
+
+    if (!path.ends_with(FAULT_LED_ASSOCIATION))
+    {
+        return;
+    }
 
-    return endpoints;
+    auto inventoryPath =
+        path.substr(0, path.size() - FAULT_LED_ASSOCIATION.size());
+    if (endpoints.empty())
+    {
+        ledGroups.erase(inventoryPath);
+    }
+    else
+    {
+        ledGroups.insert_or_assign(inventoryPath, endpoints);
+    }
+}
+
+void Monitor::associationsAddedHandler(sdbusplus::message::message& msg)
+{
+    sdbusplus::message::object_path path;
+    std::map<std::string, PropertyMap> interfaces;
+    try
+    {
+        msg.read(path, interfaces);
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        lg2::error("Failed to parse InterfacesAdded, ERROR = {ERROR}", "ERROR",
+                   e);
+        return;
+    }
+
+    auto interface = interfaces.find(ASSOCIATION_IFACE);
+    if (interface == interfaces.end())
+    {
+        return;
+    }
+
+    auto property = interface->second.find("endpoints");
+    if (property == interface->second.end())
+    {
+        return;
+    }
+
+    if (const auto* endpoints =
+            std::get_if<std::vector<std::string>>(&property->second))
+    {
+        updateAssociation(path.str, *endpoints);
+    }
+}
+
+void Monitor::associationsRemovedHandler(sdbusplus::message::message& msg)
+{
+    sdbusplus::message::object_path path;
+    std::vector<std::string> interfaces;
+    try
+    {
+        msg.read(path, interfaces);
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        lg2::error("Failed to parse InterfacesRemoved, ERROR = {ERROR}",
+                   "ERROR", e);
+        return;
+    }
+
+    if (std::find(interfaces.begin(), interfaces.end(), ASSOCIATION_IFACE) !=
+        interfaces.end())
+    {
+        updateAssociation(path.str, {});
+    }
+}
+
+void Monitor::associationChangedHandler(sdbusplus::message::message& msg)
+{
+    std::string interface;
+    PropertyMap properties;
+    try
+    {
+        msg.read(interface, properties);
+    }
+    catch (const sdbusplus::exception::exception& e)
+    {
+        lg2::error("Failed to parse PropertiesChanged, ERROR = {ERROR}",
+                   "ERROR", e);
+        return;
+    }
+
+    auto property = properties.find("endpoints");
+    if (property == properties.end())
+    {
+        return;
+    }
+
+    if (const auto* endpoints =
+            std::get_if<std::vector<std::string>>(&property->second))
+    {
+        updateAssociation(msg.get_path(), *endpoints);
+    }
 }
 
 void Monitor::updateAssertedProperty(
@@ -5,6 +5,11 @@
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server.hpp>
 
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
 namespace phosphor
 {
 namespace led
@@ -23,7 +28,9 @@ using namespace phosphor::led::utils;
  *
  *  @details This implements methods for watching OperationalStatus interface of
  *           Inventory D-Bus object and then assert corresponding LED Group
- *           D-Bus objects.
+ *           D-Bus objects. The associations of the inventory objects are
+ *           loaded from the mapper at startup, and kept up to date from its
+ *           signals.
  */
 class Monitor
 {
@@ -48,17 +55,54 @@ class Monitor
                     "arg0namespace='xyz.openbmc_project.State.Decorator."
                     "OperationalStatus'",
                     std::bind(std::mem_fn(&Monitor::matchHandler), this,
-                              std::placeholders::_1))
-
-    {}
+                              std::placeholders::_1)),
+        associationsAdded(
+            bus,
+            sdbusplus::bus::match::rules::interfacesAdded() +
+                sdbusplus::bus::match::rules::sender(MAPPER_BUSNAME),
+            std::bind(std::mem_fn(&Monitor::associationsAddedHandler), this,
+                      std::placeholders::_1)),
+        associationsRemoved(
+            bus,
+            sdbusplus::bus::match::rules::interfacesRemoved() +
+                sdbusplus::bus::match::rules::sender(MAPPER_BUSNAME),
+            std::bind(std::mem_fn(&Monitor::associationsRemovedHandler), this,
+                      std::placeholders::_1)),
+        associationsChanged(
+            bus,
+            sdbusplus::bus::match::rules::propertiesChangedNamespace(
+                "/xyz/openbmc_project/inventory",
+                "xyz.openbmc_project.Association") +
+                sdbusplus::bus::match::rules::sender(MAPPER_BUSNAME),
+            std::bind(std::mem_fn(&Monitor::associationChangedHandler), this,
+                      std::placeholders::_1))
+    {
+        loadAssociations();
+    }
 
   private:
     /** @brief sdbusplus D-Bus connection. */
     sdbusplus::bus::bus& bus;
 
+    /** @brief LED group paths of each inventory object, by its
+     *         "fault_led_group" association */
+    std::map<std::string, std::vector<std::string>> ledGroups;
+
+    /** @brief Inventory objects with the chassis critical association */
+    std::set<std::string> criticalPaths;
+
+    /** @brief True once the associations are loaded from the mapper, an
+     *         inventory object missing from the cache then has none */
+    bool associationsLoaded{false};
+
     /** @brief sdbusplus signal matches for Monitor */
     sdbusplus::bus::match_t matchSignal;
 
+    /** @brief sdbusplus signal matches for the mapper associations */
+    sdbusplus::bus::match_t associationsAdded;
+    sdbusplus::bus::match_t associationsRemoved;
+    sdbusplus::bus::match_t associationsChanged;
+
     /** DBusHandler class handles the D-Bus operations */
     DBusHandler dBusHandler;
 
@@ -81,7 +125,33 @@ class Monitor
      * @return std::vector<std::string> - Vector of LED Group D-Bus object paths
      */
     const std::vector<std::string>
-        getLedGroupPaths(const std::string& inventoryPath) const;
+        getLedGroupPaths(const std::string& inventoryPath);
+
+    /**
+     * @brief Loads the association objects of the mapper at once, into the
+     *        association caches.
+     */
+    void loadAssociations();
+
+    /**
+     * @brief Updates the association caches from the endpoints of a mapper
+     *        association object. Other association objects are ignored.
+     *
+     * @param[in] path      - Association D-Bus object path
+     * @param[in] endpoints - Its endpoints, empty when it is removed
+     */
+    void updateAssociation(const std::string& path,
+                           const std::vector<std::string>& endpoints);
+
+    /**
+     * @brief Callback handlers of the mapper signals, updating the
+     *        association caches.
+     *
+     * @param[in] msg - The D-Bus message contents
+     */
+    void associationsAddedHandler(sdbusplus::message::message& msg);
+    void associationsRemovedHandler(sdbusplus::message::message& msg);
+    void associationChangedHandler(sdbusplus::message::message& msg);
 
     /**
      * @brief Update the Asserted property of the LED Group Manager.
@@ -0,0 +1,68 @@
+#include "group-manager.hpp"
+
+#include <phosphor-logging/lg2.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace phosphor
+{
+namespace led
+{
+
+void GroupManager::setGroupsAsserted(std::map<std::string, bool> states)
+{
+    // Groups with a custom callback, e.g. the lamp test, are set on their
+    // own, the others are applied at once.
+    std::map<std::string, bool> batch;
+    std::vector<std::pair<Group*, bool>> batchGroups;
+    std::vector<std::pair<Group*, bool>> ownGroups;
+
+    // Check all the groups first, so an unknown one changes nothing
+    for (const auto& [path, value] : states)
+    {
+        auto group = findGroup(path);
+        if (group == nullptr)
+        {
+            lg2::error("Unknown LED group, PATH = {PATH}", "PATH", path);
+            throw sdbusplus::xyz::openbmc_project::Common::Error::
+                InvalidArgument();
+        }
+
+        if (group->hasCustomCallBack())
+        {
+            ownGroups.emplace_back(group, value);
+        }
+        else
+        {
+            batch.emplace(path, value);
+            batchGroups.emplace_back(group, value);
+        }
+    }
+
+    for (const auto& [group, value] : ownGroups)
+    {
+        group->asserted(value);
+    }
+
+    Manager::group ledsAssert{};
+    Manager::group ledsDeAssert{};
+
+    // One state update and one LED diff for all the groups
+    manager.setGroupStates(batch, ledsAssert, ledsDeAssert);
+
+    // Store asserted state
+    serialize.storeGroups(batch);
+
+    manager.driveLEDs(ledsAssert, ledsDeAssert);
+
+    // Signal the changed properties together
+    for (const auto& [group, value] : batchGroups)
+    {
+        group->assertedApplied(value);
+    }
+}
+
+} // namespace led
+} // namespace phosphor
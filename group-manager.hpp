@@ -0,0 +1,78 @@
+#pragma once
+
+#include "group.hpp"
+#include "manager.hpp"
+#include "serialize.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/object.hpp>
+#include <xyz/openbmc_project/Led/GroupManager/server.hpp>
+
+#include <functional>
+#include <map>
+#include <string>
+
+namespace phosphor
+{
+namespace led
+{
+
+namespace
+{
+using GroupManagerInherit = sdbusplus::server::object_t<
+    sdbusplus::xyz::openbmc_project::Led::server::GroupManager>;
+}
+
+/** @class GroupManager
+ *  @brief Applies the asserted state of several LED groups as one
+ *         transaction.
+ */
+class GroupManager : public GroupManagerInherit
+{
+  public:
+    GroupManager() = delete;
+    ~GroupManager() = default;
+    GroupManager(const GroupManager&) = delete;
+    GroupManager& operator=(const GroupManager&) = delete;
+    GroupManager(GroupManager&&) = delete;
+    GroupManager& operator=(GroupManager&&) = delete;
+
+    /** @brief Constructs the group manager D-Bus object
+     *
+     * @param[in] bus       - Handle to system dbus
+     * @param[in] objPath   - The D-Bus path that hosts the group manager
+     * @param[in] manager   - Reference to Manager
+     * @param[in] serialize - Serialize object
+     * @param[in] findGroup - returns the LED group of a D-Bus path, nullptr
+     *                        if unknown
+     */
+    GroupManager(sdbusplus::bus::bus& bus, const std::string& objPath,
+                 Manager& manager, Serialize& serialize,
+                 std::function<Group*(const std::string&)> findGroup) :
+        GroupManagerInherit(bus, objPath.c_str()),
+        manager(manager), serialize(serialize), findGroup(findGroup)
+    {
+        // Nothing here
+    }
+
+    /** @brief Sets the Asserted property of several groups. The LEDs are
+     *         driven and the groups stored once, then the property changes
+     *         are signaled together.
+     *
+     *  @param[in]  states  -  asserted state, keyed by D-Bus path of group
+     */
+    void setGroupsAsserted(std::map<std::string, bool> states) override;
+
+  private:
+    /** @brief Reference to Manager object */
+    Manager& manager;
+
+    /** @brief The serialize class for storing and restoring groups of LEDs */
+    Serialize& serialize;
+
+    /** @brief Returns the LED group of a D-Bus path */
+    std::function<Group*(const std::string&)> findGroup;
+};
+
+} // namespace led
+} // namespace phosphor
@@ -13,6 +13,35 @@ namespace phosphor
 namespace led
 {
 
+#ifdef IBM_SAI
+/** @brief Updates the operational status of the FRU of the SAI groups */
+static void updateSaiStatus(const std::string& path, bool value,
+                            const Manager& manager)
+{
+    // When setting the associated FRU's operational status for
+    // platform and partition SAI, we need to be sure that when
+    // the status is being set to good, both platform and partition
+    // SAI group objects are de-asserted.
+    std::string otherPath;
+    if (path == phosphor::led::ibm::PARTITION_SAI)
+    {
+        otherPath = phosphor::led::ibm::PLATFORM_SAI;
+    }
+    else if (path == phosphor::led::ibm::PLATFORM_SAI)
+    {
+        otherPath = phosphor::led::ibm::PARTITION_SAI;
+    }
+
+    if (!otherPath.empty())
+    {
+        if (value || (!value && !manager.isAsserted(otherPath)))
+        {
+            phosphor::led::ibm::setOperationalStatus(path, !value);
+        }
+    }
+}
+#endif
+
 /** @brief Overloaded Property Setter function */
 bool Group::asserted(bool value)
 {
@@ -32,51 +61,39 @@ bool Group::asserted(bool value)
             value);
     }
 
-    // Introducing these to enable gtest.
-    Manager::group ledsAssert{};
-    Manager::group ledsDeAssert{};
-
-    // Group management is handled by Manager. The populated leds* sets are not
-    // really used by production code. They are there to enable gtest for
-    // validation.
-    auto result = manager.setGroupState(path, value, ledsAssert, ledsDeAssert);
+    // Group management is handled by Manager. The LEDs are driven at the end
+    // of the current event loop dispatch, together with the other groups
+    // changed meanwhile.
+    auto result = manager.queueGroupState(path, value);
 
     // Store asserted state
     serialize.storeGroups(path, result);
 
 #ifdef IBM_SAI
-    // When setting the associated FRU's operational status for
-    // platform and partition SAI, we need to be sure that when
-    // the status is being set to good, both platform and partition
-    // SAI group objects are de-asserted.
-    std::string otherPath;
-    if (path == phosphor::led::ibm::PARTITION_SAI)
-    {
-        otherPath = phosphor::led::ibm::PLATFORM_SAI;
-    }
-    else if (path == phosphor::led::ibm::PLATFORM_SAI)
-    {
-        otherPath = phosphor::led::ibm::PARTITION_SAI;
-    }
-
-    if (!otherPath.empty())
-    {
-        if (value || (!value && !manager.isAsserted(otherPath)))
-        {
-            phosphor::led::ibm::setOperationalStatus(path, !value);
-        }
-    }
+    updateSaiStatus(path, value, manager);
 #endif
 
-    // If something does not go right here, then there should be an sdbusplus
-    // exception thrown.
-    manager.driveLEDs(ledsAssert, ledsDeAssert);
-
     // Set the base class's asserted to 'true' since the getter
     // operation is handled there.
     return sdbusplus::xyz::openbmc_project::Led::server::Group::asserted(
         result);
 }
 
+void Group::assertedApplied(bool value)
+{
+    // If the value is already what is before, return right away
+    if (value ==
+        sdbusplus::xyz::openbmc_project::Led::server::Group::asserted())
+    {
+        return;
+    }
+
+#ifdef IBM_SAI
+    updateSaiStatus(path, value, manager);
+#endif
+
+    sdbusplus::xyz::openbmc_project::Led::server::Group::asserted(value);
+}
+
 } // namespace led
 } // namespace phosphor
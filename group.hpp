@@ -66,6 +66,21 @@ class Group : public GroupInherit
      */
     bool asserted(bool value) override;
 
+    /** @brief Updates the Asserted property to a state already applied to
+     *         the Manager and stored, by a batch of group changes.
+     *
+     *  @param[in]  value   -  True or False
+     */
+    void assertedApplied(bool value);
+
+    /** @brief The group is driven by a custom callback, e.g. the lamp test,
+     *         and must be set on its own.
+     */
+    bool hasCustomCallBack() const
+    {
+        return customCallBack != nullptr;
+    }
+
   private:
     /** @brief Path of the group instance */
     std::string path;
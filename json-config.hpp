@@ -7,6 +7,7 @@
 
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <unordered_map>
 
 namespace fs = std::filesystem;
@@ -37,9 +38,14 @@ class JsonConfig
      *
      * @param[in] bus       - The D-Bus object
      * @param[in] event     - sd event handler
+     * @param[in] callBack  - Called once the config file is found on
+     *                        entity-manager. Unset, the event loop is exited
+     *                        instead.
      */
-    JsonConfig(sdbusplus::bus::bus& bus, sdeventplus::Event& event) :
-        event(event)
+    JsonConfig(sdbusplus::bus::bus& bus, sdeventplus::Event& event,
+               std::function<void(const fs::path&)> callBack = nullptr) :
+        event(event),
+        confFileCallBack(std::move(callBack))
     {
         match = std::make_unique<sdbusplus::bus::match_t>(
             bus,
@@ -126,7 +132,13 @@ class JsonConfig
         {
             match.reset();
 
-            // This results in event.loop() exiting in getSystemLedMap
+            if (confFileCallBack)
+            {
+                confFileCallBack(confFile);
+                return;
+            }
+
+            // This results in event.loop() exiting in getSystemConfFile
             event.exit(0);
         }
     }
@@ -253,6 +265,11 @@ class JsonConfig
      */
     sdeventplus::Event& event;
 
+    /**
+     * @brief Called once the config file is found on entity-manager
+     */
+    std::function<void(const fs::path&)> confFileCallBack;
+
     /**
      * @brief The JSON config file
      */
@@ -1,6 +1,7 @@
 #include "config.h"
 
 #include "json-config.hpp"
+#include "layout-cache.hpp"
 #include "ledlayout.hpp"
 
 #include <nlohmann/json.hpp>
@@ -22,36 +23,6 @@ using LedMap = std::map<std::string, LedAction>;
 // phosphor::led::Layout::Action can only be one of `Blink` and `On`
 using PriorityMap = std::map<std::string, phosphor::led::Layout::Action>;
 
-/** @brief Parse LED JSON file and output Json object
- *
- *  @param[in] path - path of LED JSON file
- *
- *  @return const Json - Json object
- */
-const Json readJson(const fs::path& path)
-{
-
-    if (!fs::exists(path) || fs::is_empty(path))
-    {
-        lg2::error("Incorrect File Path or empty file, FILE_PATH = {PATH}",
-                   "PATH", path);
-        throw std::runtime_error("Incorrect File Path or empty file");
-    }
-
-    try
-    {
-        std::ifstream jsonFile(path);
-        return Json::parse(jsonFile);
-    }
-    catch (const std::exception& e)
-    {
-        lg2::error(
-            "Failed to parse config file, ERROR = {ERROR}, FILE_PATH = {PATH}",
-            "ERROR", e, "PATH", path);
-        throw std::runtime_error("Failed to parse config file");
-    }
-}
-
 /** @brief Returns action enum based on string
  *
  *  @param[in] action - action string
@@ -98,60 +69,318 @@ void validatePriority(const std::string& name,
     }
 }
 
-/** @brief Load JSON config and return led map
- *
- *  @return LedMap - Generated an std::map of LedAction
+/** @class LedConfigSax
+ *  @brief Builds the LED map while the JSON config is scanned, without
+ *         materializing the JSON document. Priorities are validated as the
+ *         members are read.
  */
-const LedMap loadJsonConfig(const fs::path& path)
+class LedConfigSax : public nlohmann::json_sax<Json>
 {
-    LedMap ledMap{};
-    PriorityMap priorityMap{};
+  public:
+    /** @brief Constructor
+     *
+     *  @param[out] ledMap - LED map to fill
+     */
+    explicit LedConfigSax(LedMap& ledMap) : ledMap(ledMap) {}
 
-    // define the default JSON as empty
-    const Json empty{};
-    auto json = readJson(path);
-    auto leds = json.value("leds", empty);
+    bool null() override
+    {
+        return invalidValue();
+    }
 
-    for (const auto& entry : leds)
+    bool boolean(bool) override
     {
-        fs::path tmpPath(std::string{OBJPATH});
-        tmpPath /= entry.value("group", "");
-        auto objpath = tmpPath.string();
-        auto members = entry.value("members", empty);
+        return invalidValue();
+    }
+
+    bool number_integer(number_integer_t val) override
+    {
+        return number(val);
+    }
+
+    bool number_unsigned(number_unsigned_t val) override
+    {
+        return number(val);
+    }
+
+    bool number_float(number_float_t val, const string_t&) override
+    {
+        return number(val);
+    }
+
+    bool string(string_t& val) override
+    {
+        if (scopes.empty())
+        {
+            return true;
+        }
 
-        LedAction ledActions{};
-        for (const auto& member : members)
+        if (scopes.back() == Scope::member)
+        {
+            if (lastKey == "Name")
+            {
+                member.name = std::move(val);
+            }
+            else if (lastKey == "Action")
+            {
+                member.action = std::move(val);
+            }
+            else if (lastKey == "Priority")
+            {
+                member.priority = std::move(val);
+            }
+            else if (lastKey == "DutyOn" || lastKey == "Period")
+            {
+                return invalidValue();
+            }
+        }
+        else if (scopes.back() == Scope::group && lastKey == "group")
         {
-            auto name = member.value("Name", "");
-            auto action = getAction(member.value("Action", ""));
-            uint8_t dutyOn = member.value("DutyOn", 50);
-            uint16_t period = member.value("Period", 0);
+            group = std::move(val);
+        }
+        return true;
+    }
 
-            // Since only have Blink/On and default priority is Blink
-            auto priority = getAction(member.value("Priority", "Blink"));
+    bool binary(binary_t&) override
+    {
+        return invalidValue();
+    }
 
-            // Same LEDs can be part of multiple groups. However, their
-            // priorities across groups need to match.
-            validatePriority(name, priority, priorityMap);
+    bool start_object(std::size_t) override
+    {
+        return enter(false);
+    }
 
-            phosphor::led::Layout::LedAction ledAction{name, action, dutyOn,
-                                                       period, priority};
-            ledActions.emplace(ledAction);
+    bool key(string_t& val) override
+    {
+        lastKey = std::move(val);
+        return true;
+    }
+
+    bool end_object() override
+    {
+        if (scopes.back() == Scope::member)
+        {
+            addMember();
+        }
+        else if (scopes.back() == Scope::group)
+        {
+            addGroup();
         }
+        scopes.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t) override
+    {
+        return enter(true);
+    }
+
+    bool end_array() override
+    {
+        scopes.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&,
+                     const nlohmann::detail::exception& ex) override
+    {
+        error = ex.what();
+        return false;
+    }
+
+    /** @brief Message of the parse error, if any */
+    std::string error;
+
+  private:
+    /** @brief Containers of the config the scanner can be in */
+    enum class Scope
+    {
+        other,
+        root,
+        leds,
+        group,
+        members,
+        member
+    };
+
+    /** @brief A member as read from the config, with the defaults */
+    struct MemberConfig
+    {
+        std::string name;
+        std::string action;
+        uint8_t dutyOn = 50;
+        uint16_t period = 0;
+        std::string priority = "Blink";
+    };
+
+    bool enter(bool array)
+    {
+        // A container is not a valid value of the known keys
+        invalidValue();
+
+        auto scope = Scope::other;
+        if (scopes.empty())
+        {
+            scope = array ? Scope::other : Scope::root;
+        }
+        else if (scopes.back() == Scope::root && array && lastKey == "leds")
+        {
+            scope = Scope::leds;
+        }
+        else if (scopes.back() == Scope::leds && !array)
+        {
+            scope = Scope::group;
+            group.clear();
+            groupActions.clear();
+        }
+        else if (scopes.back() == Scope::group && array && lastKey == "members")
+        {
+            scope = Scope::members;
+        }
+        else if (scopes.back() == Scope::members && !array)
+        {
+            scope = Scope::member;
+            member = MemberConfig{};
+        }
+
+        scopes.push_back(scope);
+        return true;
+    }
+
+    template <typename T>
+    bool number(T val)
+    {
+        if (scopes.empty())
+        {
+            return true;
+        }
+
+        if (scopes.back() == Scope::member)
+        {
+            if (lastKey == "DutyOn")
+            {
+                member.dutyOn = static_cast<uint8_t>(val);
+            }
+            else if (lastKey == "Period")
+            {
+                member.period = static_cast<uint16_t>(val);
+            }
+            else if (lastKey == "Name" || lastKey == "Action" ||
+                     lastKey == "Priority")
+            {
+                return invalidValue();
+            }
+        }
+        else if (scopes.back() == Scope::group && lastKey == "group")
+        {
+            return invalidValue();
+        }
+        return true;
+    }
+
+    bool invalidValue()
+    {
+        if (scopes.empty() ||
+            (scopes.back() != Scope::member && scopes.back() != Scope::group))
+        {
+            return true;
+        }
+
+        if ((scopes.back() == Scope::member &&
+             (lastKey == "Name" || lastKey == "Action" ||
+              lastKey == "Priority" || lastKey == "DutyOn" ||
+              lastKey == "Period")) ||
+            (scopes.back() == Scope::group && lastKey == "group"))
+        {
+            lg2::error("Invalid type of LED config value, KEY = {KEY}", "KEY",
+                       lastKey);
+            throw std::runtime_error("Invalid type of LED config value");
+        }
+        return true;
+    }
+
+    void addMember()
+    {
+        auto action = getAction(member.action);
+
+        // Since only have Blink/On and default priority is Blink
+        auto priority = getAction(member.priority);
+
+        // Same LEDs can be part of multiple groups. However, their
+        // priorities across groups need to match.
+        validatePriority(member.name, priority, priorityMap);
+
+        groupActions.emplace(phosphor::led::Layout::LedAction{
+            std::move(member.name), action, member.dutyOn, member.period,
+            priority});
+    }
+
+    void addGroup()
+    {
+        fs::path tmpPath(std::string{OBJPATH});
+        tmpPath /= group;
 
         // Generated an std::map of LedGroupNames to std::set of LEDs
         // containing the name and properties.
-        ledMap.emplace(objpath, ledActions);
+        ledMap.emplace(tmpPath.string(), std::move(groupActions));
+    }
+
+    /** @brief LED map being built */
+    LedMap& ledMap;
+
+    /** @brief Priority of every LED seen so far */
+    PriorityMap priorityMap;
+
+    /** @brief Containers enclosing the current position */
+    std::vector<Scope> scopes;
+
+    /** @brief Last lastKey read */
+    std::string lastKey;
+
+    /** @brief Name of the group being read */
+    std::string group;
+
+    /** @brief Actions of the group being read */
+    LedAction groupActions;
+
+    /** @brief Member being read */
+    MemberConfig member;
+};
+
+/** @brief Load JSON config and return led map
+ *
+ *  @return LedMap - Generated an std::map of LedAction
+ */
+const LedMap loadJsonConfig(const fs::path& path)
+{
+    if (!fs::exists(path) || fs::is_empty(path))
+    {
+        lg2::error("Incorrect File Path or empty file, FILE_PATH = {PATH}",
+                   "PATH", path);
+        throw std::runtime_error("Incorrect File Path or empty file");
+    }
+
+    LedMap ledMap{};
+    LedConfigSax sax(ledMap);
+
+    std::ifstream jsonFile(path);
+    if (!Json::sax_parse(jsonFile, &sax))
+    {
+        lg2::error(
+            "Failed to parse config file, ERROR = {ERROR}, FILE_PATH = {PATH}",
+            "ERROR", sax.error, "PATH", path);
+        throw std::runtime_error("Failed to parse config file");
     }
 
     return ledMap;
 }
 
-/** @brief Get led map from LED groups JSON config
+/** @brief Get the path of the LED groups JSON config of the system
  *
- *  @return LedMap - Generated an std::map of LedAction
+ *  @return fs::path - path of the JSON config
  */
-const LedMap getSystemLedMap()
+const fs::path getSystemConfFile()
 {
     // Get a new Dbus
     auto bus = sdbusplus::bus::new_bus();
@@ -173,5 +402,38 @@ const LedMap getSystemLedMap()
     // Detach the bus from its sd_event event loop object
     bus.detach_event();
 
-    return loadJsonConfig(jsonConfig.getConfFile());
+    return jsonConfig.getConfFile();
+}
+
+/** @brief Get led map from LED groups JSON config
+ *
+ *  @return LedMap - Generated an std::map of LedAction
+ */
+const LedMap getSystemLedMap()
+{
+    return loadJsonConfig(getSystemConfFile());
+}
+
+/** @brief Get the compiled layout of an LED groups JSON config, from the
+ *         layout cache when it is up to date, or else by parsing the JSON
+ *         config and refreshing the cache.
+ *
+ *  @param[in] confFile - path of the JSON config
+ *  @param[in] cache    - path of the layout cache
+ *
+ *  @return CompiledLayout - compiled LED groups layout
+ */
+phosphor::led::Layout::CompiledLayout
+    getLayout(const fs::path& confFile,
+              const fs::path& cache = LED_LAYOUT_CACHE_FILE)
+{
+    auto layout = phosphor::led::Layout::loadCache(cache, confFile);
+    if (layout)
+    {
+        return std::move(*layout);
+    }
+
+    phosphor::led::Layout::CompiledLayout compiled(loadJsonConfig(confFile));
+    phosphor::led::Layout::storeCache(cache, compiled, confFile);
+    return compiled;
 }
@@ -0,0 +1,373 @@
+#include "layout-cache.hpp"
+
+#include "utils.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <phosphor-logging/lg2.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace phosphor
+{
+namespace led
+{
+namespace Layout
+{
+
+namespace
+{
+
+constexpr std::array<char, 4> cacheMagic = {'L', 'E', 'D', 'L'};
+constexpr uint16_t cacheVersion = 1;
+constexpr size_t cacheCrcSize = 4;
+
+/** @class Writer
+ *  @brief Appends little endian integers and strings to a buffer
+ */
+class Writer
+{
+  public:
+    void put(uint64_t value, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            data.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void putString(std::string_view value)
+    {
+        put(value.size(), 2);
+        data += value;
+    }
+
+    std::string data;
+};
+
+/** @class Reader
+ *  @brief Reads little endian integers and strings from a buffer. Reading
+ *         past the end returns zeroes and clears ok.
+ */
+class Reader
+{
+  public:
+    explicit Reader(std::string_view data) : data(data) {}
+
+    uint64_t get(size_t bytes)
+    {
+        if (data.size() - offset < bytes)
+        {
+            ok = false;
+            offset = data.size();
+            return 0;
+        }
+
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            value |= static_cast<uint64_t>(
+                         static_cast<uint8_t>(data[offset + i]))
+                     << (8 * i);
+        }
+        offset += bytes;
+        return value;
+    }
+
+    std::string getString()
+    {
+        auto size = get(2);
+        if (data.size() - offset < size)
+        {
+            ok = false;
+            offset = data.size();
+            return {};
+        }
+
+        std::string value(data.substr(offset, size));
+        offset += size;
+        return value;
+    }
+
+    bool atEnd() const
+    {
+        return offset == data.size();
+    }
+
+    bool ok{true};
+
+  private:
+    std::string_view data;
+    size_t offset{0};
+};
+
+/** @class MappedFile
+ *  @brief Read only memory mapping of a whole file
+ */
+class MappedFile
+{
+  public:
+    explicit MappedFile(const fs::path& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE,
+                                fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                this->addr = addr;
+                size = st.st_size;
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (addr)
+        {
+            ::munmap(addr, size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /** @brief Content of the file, std::nullopt if it could not be mapped */
+    std::optional<std::string_view> content() const
+    {
+        if (!addr)
+        {
+            return std::nullopt;
+        }
+        return std::string_view(static_cast<const char*>(addr), size);
+    }
+
+  private:
+    void* addr{nullptr};
+    size_t size{0};
+};
+
+} // namespace
+
+uint64_t getSourceKey(std::string_view source)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 0xCBF29CE484222325;
+    for (auto c : source)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001B3;
+    }
+    return hash;
+}
+
+std::string encodeCache(const CompiledLayout& layout, uint64_t sourceKey)
+{
+    Writer writer;
+    writer.data.assign(cacheMagic.begin(), cacheMagic.end());
+    writer.put(cacheVersion, 2);
+    writer.put(sourceKey, 8);
+
+    uint32_t memberCount = 0;
+    for (size_t id = 0; id < layout.groupCount(); ++id)
+    {
+        memberCount += layout.groupMembers(id).size();
+    }
+    writer.put(layout.groupCount(), 4);
+    writer.put(layout.ledCount(), 4);
+    writer.put(memberCount, 4);
+
+    for (size_t id = 0; id < layout.groupCount(); ++id)
+    {
+        writer.putString(layout.groupPath(id));
+    }
+    for (size_t id = 0; id < layout.ledCount(); ++id)
+    {
+        writer.putString(layout.ledName(id));
+    }
+
+    uint32_t offset = 0;
+    writer.put(offset, 4);
+    for (size_t id = 0; id < layout.groupCount(); ++id)
+    {
+        offset += layout.groupMembers(id).size();
+        writer.put(offset, 4);
+    }
+
+    for (size_t id = 0; id < layout.groupCount(); ++id)
+    {
+        for (const auto& member : layout.groupMembers(id))
+        {
+            writer.put(member.led, 2);
+            writer.put(member.action, 1);
+            writer.put(member.dutyOn, 1);
+            writer.put(member.period, 2);
+            writer.put(member.priority, 1);
+        }
+    }
+
+    writer.put(utils::crc32(writer.data), cacheCrcSize);
+    return std::move(writer.data);
+}
+
+std::optional<CompiledLayout> decodeCache(std::string_view data,
+                                          uint64_t sourceKey)
+{
+    if (data.size() < cacheMagic.size() + cacheCrcSize ||
+        !std::equal(cacheMagic.begin(), cacheMagic.end(), data.begin()))
+    {
+        return std::nullopt;
+    }
+
+    auto body = data.substr(0, data.size() - cacheCrcSize);
+    Reader crc(data.substr(body.size()));
+    if (crc.get(cacheCrcSize) != utils::crc32(body))
+    {
+        return std::nullopt;
+    }
+
+    Reader reader(body.substr(cacheMagic.size()));
+    if (reader.get(2) != cacheVersion || reader.get(8) != sourceKey)
+    {
+        return std::nullopt;
+    }
+
+    auto groupCount = reader.get(4);
+    auto ledCount = reader.get(4);
+    auto memberCount = reader.get(4);
+
+    // Every entry takes at least one byte, bound the allocations by the size
+    // of the cache.
+    if (groupCount + ledCount + memberCount > body.size())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<std::string> groups;
+    groups.reserve(groupCount);
+    for (uint64_t i = 0; i < groupCount; ++i)
+    {
+        groups.emplace_back(reader.getString());
+    }
+
+    std::vector<std::string> leds;
+    leds.reserve(ledCount);
+    for (uint64_t i = 0; i < ledCount; ++i)
+    {
+        leds.emplace_back(reader.getString());
+    }
+
+    std::vector<uint32_t> offsets;
+    offsets.reserve(groupCount + 1);
+    for (uint64_t i = 0; i <= groupCount; ++i)
+    {
+        offsets.push_back(reader.get(4));
+    }
+
+    std::vector<Member> members;
+    members.reserve(memberCount);
+    for (uint64_t i = 0; i < memberCount; ++i)
+    {
+        Member member{};
+        member.led = reader.get(2);
+        auto action = reader.get(1);
+        member.dutyOn = reader.get(1);
+        member.period = reader.get(2);
+        auto priority = reader.get(1);
+        if (action > Blink || priority > Blink)
+        {
+            return std::nullopt;
+        }
+        member.action = static_cast<Action>(action);
+        member.priority = static_cast<Action>(priority);
+        members.push_back(member);
+    }
+
+    if (!reader.ok || !reader.atEnd())
+    {
+        return std::nullopt;
+    }
+
+    try
+    {
+        return CompiledLayout(groups, leds, std::move(members),
+                              std::move(offsets));
+    }
+    catch (const std::exception&)
+    {
+        return std::nullopt;
+    }
+}
+
+std::optional<CompiledLayout> loadCache(const fs::path& cache,
+                                        const fs::path& source)
+{
+    MappedFile sourceFile(source);
+    auto sourceContent = sourceFile.content();
+    if (!sourceContent)
+    {
+        return std::nullopt;
+    }
+
+    MappedFile cacheFile(cache);
+    auto cacheContent = cacheFile.content();
+    if (!cacheContent)
+    {
+        lg2::info("No LED layout cache, FILE_PATH = {PATH}", "PATH", cache);
+        return std::nullopt;
+    }
+
+    auto layout = decodeCache(*cacheContent, getSourceKey(*sourceContent));
+    if (!layout)
+    {
+        lg2::info("Stale or invalid LED layout cache, FILE_PATH = {PATH}",
+                  "PATH", cache);
+    }
+    return layout;
+}
+
+bool storeCache(const fs::path& cache, const CompiledLayout& layout,
+                const fs::path& source)
+{
+    MappedFile sourceFile(source);
+    auto sourceContent = sourceFile.content();
+    if (!sourceContent)
+    {
+        lg2::error("Failed to read LED config, FILE_PATH = {PATH}", "PATH",
+                   source);
+        return false;
+    }
+
+    auto data = encodeCache(layout, getSourceKey(*sourceContent));
+
+    // Replace the cache atomically and durably, a concurrent reader or a
+    // power loss sees either cache
+    std::error_code ec;
+    fs::create_directories(cache.parent_path(), ec);
+    if (auto error = utils::writeFileAtomic(cache, data))
+    {
+        lg2::error(
+            "Failed to write LED layout cache, FILE_PATH = {PATH}, ERROR = {ERROR}",
+            "PATH", cache, "ERROR", strerror(error));
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Layout
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ledlayout.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace phosphor
+{
+namespace led
+{
+namespace Layout
+{
+
+namespace fs = std::filesystem;
+
+/** @brief Key of the LED config a cached layout was compiled from. It is a
+ *         hash of the content, as modification times are not preserved
+ *         when the cache is generated at image build time.
+ *
+ *  @param[in] source - content of the LED config
+ *
+ *  @return key of the config
+ */
+uint64_t getSourceKey(std::string_view source);
+
+/** @brief Encodes a layout into the layout cache format
+ *
+ *  The cache holds, all integers little endian: a magic, the version, the
+ *  source key, the group, LED and member counts, the length prefixed group
+ *  paths and LED names, the offset table, the members, and a CRC-32 of all
+ *  the preceding bytes.
+ *
+ *  @param[in] layout    - compiled layout
+ *  @param[in] sourceKey - key of the LED config it was compiled from
+ *
+ *  @return content of the cache file
+ */
+std::string encodeCache(const CompiledLayout& layout, uint64_t sourceKey);
+
+/** @brief Decodes a layout cache
+ *
+ *  @param[in] data      - content of the cache file
+ *  @param[in] sourceKey - key of the current LED config
+ *
+ *  @return the layout, std::nullopt if the cache is corrupted, of another
+ *          version or compiled from another config
+ */
+std::optional<CompiledLayout> decodeCache(std::string_view data,
+                                          uint64_t sourceKey);
+
+/** @brief Loads the layout cache of an LED config, by mapping it
+ *
+ *  @param[in] cache  - path of the cache file
+ *  @param[in] source - path of the LED config
+ *
+ *  @return the layout, std::nullopt if there is no up to date cache
+ */
+std::optional<CompiledLayout> loadCache(const fs::path& cache,
+                                        const fs::path& source);
+
+/** @brief Writes the layout cache of an LED config
+ *
+ *  @param[in] cache  - path of the cache file
+ *  @param[in] layout - layout compiled from the config
+ *  @param[in] source - path of the LED config
+ *
+ *  @return true: written, false: failed and logged
+ */
+bool storeCache(const fs::path& cache, const CompiledLayout& layout,
+                const fs::path& source);
+
+} // namespace Layout
+} // namespace led
+} // namespace phosphor
@@ -0,0 +1,38 @@
+#include "config.h"
+
+#include "json-parser.hpp"
+#include "layout-cache.hpp"
+#include "ledlayout.hpp"
+
+#include <iostream>
+
+/** @brief Compiles an LED groups JSON config into a layout cache, so that
+ *         phosphor-ledmanager doesn't parse the JSON config at startup.
+ *         Meant to run at image build time.
+ */
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <led-group-config.json> <cache>"
+                  << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        phosphor::led::Layout::CompiledLayout layout(loadJsonConfig(argv[1]));
+        if (!phosphor::led::Layout::storeCache(argv[2], layout, argv[1]))
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Failed to compile " << argv[1] << ": " << e.what()
+                  << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
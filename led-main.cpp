@@ -1,11 +1,15 @@
 #include "config.h"
 
+#include "group-manager.hpp"
 #include "group.hpp"
 #ifdef LED_USE_JSON
 #include "json-parser.hpp"
 #else
 #include "led-gen.hpp"
 #endif
+#ifdef CONFIG_HOT_RELOAD
+#include "config-watcher.hpp"
+#endif
 #include "ledlayout.hpp"
 #include "manager.hpp"
 #include "serialize.hpp"
@@ -14,9 +18,150 @@
 #include "lamptest.hpp"
 #endif
 
+#include <phosphor-logging/lg2.hpp>
 #include <sdeventplus/event.hpp>
+#include <sdeventplus/source/signal.hpp>
 
+#include <chrono>
+#include <csignal>
 #include <iostream>
+#include <map>
+#include <memory>
+
+/** @class LedGroups
+ *  @brief The group manager and the LED group objects, created once the LED
+ *         layout is known
+ */
+struct LedGroups
+{
+    LedGroups(sdbusplus::bus_t& bus,
+              phosphor::led::Layout::CompiledLayout layout,
+              phosphor::led::Serialize& serialize,
+              const sdeventplus::Event& event) :
+        bus(bus),
+        serialize(serialize), manager(bus, std::move(layout), event),
+#ifdef USE_LAMP_TEST
+        lampTest(event, manager),
+#endif
+        groupManager(bus, OBJPATH, manager, serialize,
+                     [this](const std::string& path) {
+            return findGroup(path);
+        })
+    {
+#ifdef USE_LAMP_TEST
+        lampTestGroup = std::make_unique<phosphor::led::Group>(
+            bus, LAMP_TEST_OBJECT, manager, serialize,
+            std::bind(std::mem_fn(&phosphor::led::LampTest::requestHandler),
+                      &lampTest, std::placeholders::_1,
+                      std::placeholders::_2));
+
+        // Register a lamp test method in the manager class, and call this
+        // method when the lamp test is started
+        manager.setLampTestCallBack(std::bind(
+            std::mem_fn(&phosphor::led::LampTest::processLEDUpdates),
+            &lampTest, std::placeholders::_1, std::placeholders::_2));
+#endif
+
+        // Known LED states are not written again when the groups are
+        // restored, they are driven once the states are read
+        manager.loadPhysicalStates();
+
+        createGroups();
+    }
+
+    /** @brief Switches to a new LED layout. The groups no longer in it are
+     *         removed, the new ones added, and only the LEDs of changed
+     *         asserted groups are driven. It all happens within one event
+     *         dispatch, so clients see either the old or the new groups.
+     *
+     *  @param[in] layout - new LED layout
+     */
+    void reload(phosphor::led::Layout::CompiledLayout layout)
+    {
+        phosphor::led::Manager::group ledsAssert;
+        phosphor::led::Manager::group ledsDeAssert;
+        manager.reloadLayout(std::move(layout), ledsAssert, ledsDeAssert);
+        manager.driveLEDs(ledsAssert, ledsDeAssert);
+
+        // The removed groups are saved as deasserted, as their LEDs are, so
+        // that they are not restored asserted if they come back.
+        const auto& current = manager.getLayout();
+        std::map<std::string, bool> removed;
+        std::erase_if(groups, [&current, &removed](const auto& group) {
+            if (current.findGroup(group.first))
+            {
+                return false;
+            }
+            removed.emplace(group.first, false);
+            return true;
+        });
+        serialize.storeGroups(removed);
+
+        createGroups();
+    }
+
+    /** @brief Creates the dbus objects of the groups of the layout not
+     *         created yet. Their saved state is restored at once before,
+     *         and their LEDs are driven together once the event loop runs.
+     */
+    void createGroups()
+    {
+        const auto& layout = manager.getLayout();
+
+        std::map<std::string, bool> restored;
+        for (size_t id = 0; id < layout.groupCount(); ++id)
+        {
+            std::string path(layout.groupPath(id));
+            if (!groups.contains(path) && serialize.getGroupSavedState(path))
+            {
+                restored.emplace(std::move(path), true);
+            }
+        }
+        manager.queueGroupStates(restored);
+
+        for (size_t id = 0; id < layout.groupCount(); ++id)
+        {
+            std::string path(layout.groupPath(id));
+            if (!groups.contains(path))
+            {
+                groups.emplace(path, std::make_unique<phosphor::led::Group>(
+                                         bus, path, manager, serialize));
+            }
+        }
+    }
+
+    /** @brief Returns the LED group of a D-Bus path, nullptr if unknown */
+    phosphor::led::Group* findGroup(const std::string& path)
+    {
+#ifdef USE_LAMP_TEST
+        if (path == LAMP_TEST_OBJECT)
+        {
+            return lampTestGroup.get();
+        }
+#endif
+        auto group = groups.find(path);
+        return group != groups.end() ? group->second.get() : nullptr;
+    }
+
+    sdbusplus::bus_t& bus;
+
+    phosphor::led::Serialize& serialize;
+
+    /** @brief Group manager object, holding the compiled LED layout */
+    phosphor::led::Manager manager;
+
+#ifdef USE_LAMP_TEST
+    phosphor::led::LampTest lampTest;
+
+    std::unique_ptr<phosphor::led::Group> lampTestGroup;
+#endif
+
+    /** @brief led groups, keyed by D-Bus path */
+    std::map<std::string, std::unique_ptr<phosphor::led::Group>> groups;
+
+    /** @brief dbus object setting several groups at once */
+    phosphor::led::GroupManager groupManager;
+};
 
 int main(void)
 {
@@ -26,50 +171,144 @@ int main(void)
     /** @brief Dbus constructs used by LED Group manager */
     auto& bus = phosphor::led::utils::DBusHandler::getBus();
 
-#ifdef LED_USE_JSON
-    auto systemLedMap = getSystemLedMap();
+    /** @brief sd_bus object manager */
+    sdbusplus::server::manager::manager objManager(bus, OBJPATH);
+
+#ifdef SAVE_GROUPS_BINARY
+    constexpr auto saveFormat = phosphor::led::Serialize::Format::binary;
+#else
+    constexpr auto saveFormat = phosphor::led::Serialize::Format::json;
+#endif
+
+#if SAVE_GROUPS_DELAY_IN_MSECS > 0
+    /** @brief store and re-store Group, saving once the groups settle */
+    phosphor::led::Serialize serialize(
+        SAVED_GROUPS_FILE, event,
+        std::chrono::milliseconds(SAVE_GROUPS_DELAY_IN_MSECS), saveFormat,
+        SAVE_GROUPS_JOURNAL_LIMIT);
+#else
+    /** @brief store and re-store Group, saving on every change */
+    phosphor::led::Serialize serialize(SAVED_GROUPS_FILE, saveFormat,
+                                       SAVE_GROUPS_JOURNAL_LIMIT);
 #endif
 
-    /** @brief Group manager object */
-    phosphor::led::Manager manager(bus, systemLedMap, event);
+    /** @brief Save the pending group changes before being stopped */
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    sdeventplus::source::Signal sigterm(
+        event, SIGTERM,
+        [&serialize](sdeventplus::source::Signal& source,
+                     const struct signalfd_siginfo*) {
+        serialize.flush();
+        source.get_event().exit(0);
+    });
 
-    /** @brief sd_bus object manager */
-    sdbusplus::server::manager::manager objManager(bus, OBJPATH);
+    std::unique_ptr<LedGroups> ledGroups;
 
-    /** @brief vector of led groups */
-    std::vector<std::unique_ptr<phosphor::led::Group>> groups;
+    /** @brief Log the service cache statistics and the physical LEDs
+     *         failing to be driven on request
+     */
+    sdeventplus::source::Signal sigusr1(
+        event, SIGUSR1,
+        [&ledGroups](sdeventplus::source::Signal&,
+                     const struct signalfd_siginfo*) {
+        using phosphor::led::utils::DBusHandler;
+        const auto& cache = DBusHandler::getServiceCache();
+        lg2::info(
+            "Service cache, HITS = {HITS}, MISSES = {MISSES}, SIZE = {SIZE}",
+            "HITS", cache.hits(), "MISSES", cache.misses(), "SIZE",
+            cache.size());
 
-    /** @brief store and re-store Group */
-    phosphor::led::Serialize serialize(SAVED_GROUPS_FILE);
+        if (!ledGroups)
+        {
+            return;
+        }
 
-#ifdef USE_LAMP_TEST
-    phosphor::led::LampTest lampTest(event, manager);
-
-    groups.emplace_back(std::make_unique<phosphor::led::Group>(
-        bus, LAMP_TEST_OBJECT, manager, serialize,
-        std::bind(std::mem_fn(&phosphor::led::LampTest::requestHandler),
-                  &lampTest, std::placeholders::_1, std::placeholders::_2)));
-
-    // Register a lamp test method in the manager class, and call this method
-    // when the lamp test is started
-    manager.setLampTestCallBack(
-        std::bind(std::mem_fn(&phosphor::led::LampTest::processLEDUpdates),
-                  &lampTest, std::placeholders::_1, std::placeholders::_2));
+        const auto& retries = ledGroups->manager.getRetries();
+        lg2::info(
+            "Physical LED retries, RETRIES = {RETRIES}, EXHAUSTED = {EXHAUSTED}, FAILING = {FAILING}",
+            "RETRIES", retries.getRetryCount(), "EXHAUSTED",
+            retries.getExhaustedCount(), "FAILING", retries.getLeds().size());
+        for (const auto& [name, retry] : retries.getLeds())
+        {
+            lg2::info(
+                "Physical LED failing, NAME = {NAME}, ATTEMPTS = {ATTEMPTS}, STUCK = {STUCK}",
+                "NAME", name, "ATTEMPTS", retry.attempts, "STUCK",
+                retry.exhausted);
+        }
+    });
+
+#ifdef LED_USE_JSON
+#ifdef CONFIG_HOT_RELOAD
+    std::unique_ptr<phosphor::led::ConfigWatcher> configWatcher;
+#endif
+
+    auto createGroups = [&](const fs::path& confFile) {
+        ledGroups = std::make_unique<LedGroups>(bus, getLayout(confFile),
+                                                serialize, event);
+#ifdef CONFIG_HOT_RELOAD
+        // A config failing to load keeps the current layout in place. The
+        // override config is switched to once added.
+        configWatcher = std::make_unique<phosphor::led::ConfigWatcher>(
+            event, confFile,
+            fs::path{phosphor::led::confOverridePath} /
+                phosphor::led::confFileName,
+            [&ledGroups](const fs::path& confFile) {
+            try
+            {
+                ledGroups->reload(getLayout(confFile));
+            }
+            catch (const std::exception& e)
+            {
+                lg2::error("Failed to reload LED config, ERROR = {ERROR}",
+                           "ERROR", e);
+            }
+        });
 #endif
+    };
+#endif
+
+#if defined(LED_USE_JSON) && defined(ASYNC_CONFIG_DISCOVERY)
+    // Serve requests while the JSON config is being discovered, the groups
+    // show up once it is found.
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    bus.request_name(BUSNAME);
 
-    /** Now create so many dbus objects as there are groups */
-    for (auto& grp : systemLedMap)
+    phosphor::led::JsonConfig jsonConfig(
+        bus, event, [&](const fs::path& confFile) {
+        try
+        {
+            createGroups(confFile);
+        }
+        catch (const std::exception& e)
+        {
+            lg2::error("Failed to create LED groups, ERROR = {ERROR}", "ERROR",
+                       e);
+            event.exit(EXIT_FAILURE);
+        }
+    });
+    if (!jsonConfig.getConfFile().empty())
     {
-        groups.emplace_back(std::make_unique<phosphor::led::Group>(
-            bus, grp.first, manager, serialize));
+        createGroups(jsonConfig.getConfFile());
     }
-
-    // Attach the bus to sd_event to service user requests
+#else
+    // Attach the bus to sd_event to service user requests, they are
+    // dispatched once the groups are created and the event loop runs.
     bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
 
     /** @brief Claim the bus */
     bus.request_name(BUSNAME);
-    event.loop();
 
-    return 0;
+#ifdef LED_USE_JSON
+    createGroups(getSystemConfFile());
+#else
+    ledGroups =
+        std::make_unique<LedGroups>(bus, systemLayout, serialize, event);
+#endif
+#endif
+
+    return event.loop();
 }
@@ -1,8 +1,19 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <set>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace phosphor
 {
@@ -16,7 +27,7 @@ namespace Layout
 /** @brief Define possible actions on a given LED.
  *  For the BLINK operation, follow 50-50 duty cycle
  */
-enum Action
+enum Action : uint8_t
 {
     Off,
     On,
@@ -53,6 +64,502 @@ struct LedAction
         return name < right.name;
     }
 };
+
+/** @brief Map of group D-Bus path to the actions of its LEDs, as read from
+ *         the JSON config or the generated header.
+ */
+using GroupMap = std::map<std::string, std::set<LedAction>>;
+
+/** @brief Dense identifier of an interned LED name or group path */
+using NameId = uint16_t;
+
+/** @brief Member of a group with the LED addressed by its interned id.
+ *  This is the compact form of LedAction used internally by the Manager.
+ */
+struct Member
+{
+    NameId led;
+    Action action;
+    uint8_t dutyOn;
+    uint16_t period;
+    Action priority;
+};
+
+/** @class NameTable
+ *  @brief Assigns dense integer ids to names, in order of first appearance
+ */
+class NameTable
+{
+  public:
+    /** @brief Returns the id of the name, interning it if not yet known
+     *
+     *  @param[in] name - LED name or group path
+     *
+     *  @return NameId  - id of the name
+     */
+    NameId intern(const std::string& name)
+    {
+        auto [iter, added] =
+            ids.try_emplace(name, static_cast<NameId>(names.size()));
+        if (added)
+        {
+            if (names.size() > UINT16_MAX)
+            {
+                ids.erase(iter);
+                throw std::length_error("Too many names to intern");
+            }
+            names.emplace_back(name);
+        }
+        return iter->second;
+    }
+
+    /** @brief Returns the id of an already interned name
+     *
+     *  @param[in] name - LED name or group path
+     *
+     *  @return id of the name, std::nullopt if it is not known
+     */
+    std::optional<NameId> find(std::string_view name) const
+    {
+        auto iter = ids.find(name);
+        if (iter == ids.end())
+        {
+            return std::nullopt;
+        }
+        return iter->second;
+    }
+
+    /** @brief Returns the name behind an id */
+    const std::string& name(NameId id) const
+    {
+        return names[id];
+    }
+
+    /** @brief Number of interned names */
+    size_t size() const
+    {
+        return names.size();
+    }
+
+  private:
+    /** @brief Hash allowing the lookup of a std::string_view */
+    struct NameHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view name) const
+        {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    /** @brief Names indexed by their id */
+    std::vector<std::string> names;
+
+    /** @brief Map of name to its id */
+    std::unordered_map<std::string, NameId, NameHash, std::equal_to<>> ids;
+};
+
+/** @brief Hash of a name for the perfect hash tables, FNV-1a with a seed.
+ *         parse_led.py implements the same function.
+ *
+ *  @param[in] name - LED name or group path
+ *  @param[in] seed - seed of the hash
+ */
+constexpr uint32_t nameHash(std::string_view name, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    for (auto c : name)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/** @struct PerfectHash
+ *  @brief Collision free lookup table of a fixed set of names.
+ *
+ *  A name is first hashed with seed 0 to pick a bucket, then hashed with
+ *  the seed of the bucket to pick the slot holding its id. Seeds are chosen
+ *  when the table is built so that no two names share a slot.
+ */
+struct PerfectHash
+{
+    /** @brief Seed of every bucket */
+    std::span<const uint32_t> seeds;
+
+    /** @brief Id of the name hashed to every slot */
+    std::span<const NameId> slots;
+
+    /** @brief Returns the id of a name
+     *
+     *  @param[in] name  - LED name or group path
+     *  @param[in] names - names indexed by id, to reject unknown names
+     *
+     *  @return id of the name, std::nullopt if it is not known
+     */
+    constexpr std::optional<NameId>
+        find(std::string_view name,
+             std::span<const std::string_view> names) const
+    {
+        if (slots.empty())
+        {
+            return std::nullopt;
+        }
+
+        auto seed = seeds[nameHash(name, 0) % seeds.size()];
+        auto id = slots[nameHash(name, seed) % slots.size()];
+        if (names[id] != name)
+        {
+            return std::nullopt;
+        }
+        return id;
+    }
+};
+
+/** @struct StaticLayout
+ *  @brief Views of the tables of a compiled layout. parse_led.py generates
+ *         them as constexpr arrays, so the layout of a non JSON build lives
+ *         in read only data. Layouts built at runtime build the same tables.
+ */
+struct StaticLayout
+{
+    /** @brief D-Bus paths of the groups, in id order */
+    std::span<const std::string_view> groupPaths;
+
+    /** @brief Names of the physical LEDs, in id order */
+    std::span<const std::string_view> ledNames;
+
+    /** @brief Members of all the groups, one group after the other */
+    std::span<const Member> members;
+
+    /** @brief Index of the first member of every group in members, followed
+     *         by the total number of members.
+     */
+    std::span<const uint32_t> offsets;
+
+    /** @brief Lookup of the group ids */
+    PerfectHash groupIndex;
+
+    /** @brief Lookup of the LED ids */
+    PerfectHash ledIndex;
+};
+
+/** @brief Builds the perfect hash of a set of distinct names, the same way
+ *         parse_led.py does.
+ *
+ *  The names are spread over buckets with seed 0, then a seed is searched
+ *  for every bucket, largest first, placing all its names in free slots.
+ *  The table grows when a bucket can't be placed.
+ *
+ *  @param[in]  names - names indexed by id
+ *  @param[out] seeds - seed of every bucket
+ *  @param[out] slots - id of the name hashed to every slot
+ */
+inline void buildPerfectHash(std::span<const std::string_view> names,
+                             std::vector<uint32_t>& seeds,
+                             std::vector<NameId>& slots)
+{
+    constexpr uint32_t maxSeed = 1u << 16;
+
+    seeds.clear();
+    slots.clear();
+    if (names.empty())
+    {
+        return;
+    }
+
+    std::vector<std::vector<NameId>> buckets((names.size() + 3) / 4);
+    for (size_t id = 0; id < names.size(); ++id)
+    {
+        buckets[nameHash(names[id], 0) % buckets.size()].push_back(
+            static_cast<NameId>(id));
+    }
+
+    std::vector<size_t> order(buckets.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&buckets](size_t left, size_t right) {
+        return buckets[left].size() > buckets[right].size();
+    });
+
+    std::vector<size_t> placed;
+    for (auto slotCount = names.size();; slotCount += names.size() / 8 + 1)
+    {
+        std::vector<bool> used(slotCount);
+        seeds.assign(buckets.size(), 0);
+        slots.assign(slotCount, 0);
+
+        bool done = true;
+        for (auto bucket : order)
+        {
+            uint32_t seed = 1;
+            for (; seed < maxSeed; ++seed)
+            {
+                placed.clear();
+                for (auto id : buckets[bucket])
+                {
+                    auto slot = nameHash(names[id], seed) % slotCount;
+                    if (used[slot] || std::find(placed.begin(), placed.end(),
+                                                slot) != placed.end())
+                    {
+                        break;
+                    }
+                    placed.push_back(slot);
+                }
+                if (placed.size() == buckets[bucket].size())
+                {
+                    break;
+                }
+            }
+
+            if (seed == maxSeed)
+            {
+                done = false;
+                break;
+            }
+
+            seeds[bucket] = seed;
+            for (size_t i = 0; i < placed.size(); ++i)
+            {
+                used[placed[i]] = true;
+                slots[placed[i]] = buckets[bucket][i];
+            }
+        }
+
+        if (done)
+        {
+            return;
+        }
+    }
+}
+
+/** @class CompiledLayout
+ *  @brief Immutable, flat form of the LED group layout.
+ *
+ *  The members of all the groups are packed in one array, with the members of
+ *  a group found between two consecutive entries of the offset table. Groups
+ *  are numbered in the order of their D-Bus paths.
+ *
+ *  The tables are either generated at build time, or built at runtime and
+ *  shared by the copies of the layout.
+ */
+class CompiledLayout
+{
+  public:
+    CompiledLayout() = default;
+
+    /** @brief Uses a layout generated at build time, without copying it
+     *
+     *  @param[in] layout - generated layout
+     */
+    constexpr CompiledLayout(const StaticLayout& layout) : view(layout) {}
+
+    /** @brief Compiles the layout of the groups
+     *
+     *  @param[in] groupMap - LEDs group layout
+     */
+    CompiledLayout(const GroupMap& groupMap)
+    {
+        auto built = std::make_shared<Storage>();
+        built->offsets.reserve(groupMap.size() + 1);
+        built->offsets.push_back(0);
+
+        NameTable groupPaths;
+        NameTable ledNames;
+        for (const auto& [path, actions] : groupMap)
+        {
+            groupPaths.intern(path);
+            for (const auto& led : actions)
+            {
+                built->members.push_back({ledNames.intern(led.name),
+                                          led.action, led.dutyOn, led.period,
+                                          led.priority});
+            }
+            built->offsets.push_back(
+                static_cast<uint32_t>(built->members.size()));
+        }
+
+        built->members.shrink_to_fit();
+        use(std::move(built), groupPaths, ledNames);
+    }
+
+    /** @brief Rebuilds a layout from its compiled form, as stored in the
+     *         layout cache.
+     *
+     *  @param[in] groups     - D-Bus paths of the groups, in id order
+     *  @param[in] leds       - names of the physical LEDs, in id order
+     *  @param[in] allMembers - members of all the groups
+     *  @param[in] memberEnds - offset table, see groupMembers()
+     *
+     *  std::invalid_argument thrown if the parts are inconsistent
+     */
+    CompiledLayout(const std::vector<std::string>& groups,
+                   const std::vector<std::string>& leds,
+                   std::vector<Member> allMembers,
+                   std::vector<uint32_t> memberEnds)
+    {
+        auto built = std::make_shared<Storage>();
+        built->members = std::move(allMembers);
+        built->offsets = std::move(memberEnds);
+
+        NameTable groupPaths;
+        NameTable ledNames;
+        for (const auto& path : groups)
+        {
+            groupPaths.intern(path);
+        }
+        for (const auto& name : leds)
+        {
+            ledNames.intern(name);
+        }
+
+        const auto& members = built->members;
+        const auto& offsets = built->offsets;
+        if (groupPaths.size() != groups.size() ||
+            ledNames.size() != leds.size() ||
+            offsets.size() != groups.size() + 1 || offsets.front() != 0 ||
+            offsets.back() != members.size() ||
+            !std::is_sorted(offsets.begin(), offsets.end()) ||
+            std::any_of(members.begin(), members.end(),
+                        [&leds](const auto& member) {
+            return member.led >= leds.size();
+        }))
+        {
+            throw std::invalid_argument("Inconsistent compiled LED layout");
+        }
+
+        use(std::move(built), groupPaths, ledNames);
+    }
+
+    /** @brief Number of groups in the layout */
+    size_t groupCount() const
+    {
+        return view.groupPaths.size();
+    }
+
+    /** @brief Number of distinct physical LEDs in the layout */
+    size_t ledCount() const
+    {
+        return view.ledNames.size();
+    }
+
+    /** @brief Returns the D-Bus path of a group */
+    std::string_view groupPath(NameId group) const
+    {
+        return view.groupPaths[group];
+    }
+
+    /** @brief Returns the name of a physical LED */
+    std::string_view ledName(NameId led) const
+    {
+        return view.ledNames[led];
+    }
+
+    /** @brief Returns the id of a group from its D-Bus path */
+    std::optional<NameId> findGroup(std::string_view path) const
+    {
+        return view.groupIndex.find(path, view.groupPaths);
+    }
+
+    /** @brief Returns the id of a physical LED from its name */
+    std::optional<NameId> findLed(std::string_view name) const
+    {
+        return view.ledIndex.find(name, view.ledNames);
+    }
+
+    /** @brief Returns the members of a group */
+    std::span<const Member> groupMembers(NameId group) const
+    {
+        return view.members.subspan(
+            view.offsets[group], view.offsets[group + 1] - view.offsets[group]);
+    }
+
+  private:
+    /** @brief Tables of a layout built at runtime */
+    struct Storage
+    {
+        /** @brief Group paths then LED names, one after the other */
+        std::string names;
+
+        /** @brief Views of the names, in id order */
+        std::vector<std::string_view> groupPathViews;
+        std::vector<std::string_view> ledNameViews;
+
+        /** @brief Members of all the groups, one group after the other */
+        std::vector<Member> members;
+
+        /** @brief Offset table, see StaticLayout::offsets */
+        std::vector<uint32_t> offsets;
+
+        /** @brief Perfect hash tables of the group paths and LED names */
+        std::vector<uint32_t> groupSeeds;
+        std::vector<NameId> groupSlots;
+        std::vector<uint32_t> ledSeeds;
+        std::vector<NameId> ledSlots;
+    };
+
+    /** @brief Copies the interned names into one buffer of the tables,
+     *         points the views at them and builds the perfect hash of the
+     *         names.
+     *
+     *  @param[in] built      - tables built at runtime
+     *  @param[in] groupPaths - interned group paths
+     *  @param[in] ledNames   - interned LED names
+     */
+    void use(std::shared_ptr<Storage> built, const NameTable& groupPaths,
+             const NameTable& ledNames)
+    {
+        size_t length = 0;
+        for (const auto* table : {&groupPaths, &ledNames})
+        {
+            for (size_t id = 0; id < table->size(); ++id)
+            {
+                length += table->name(id).size();
+            }
+        }
+
+        // The buffer is not reallocated past this point, so the views of
+        // the names stay valid.
+        auto& names = built->names;
+        names.reserve(length);
+        for (auto [table, views] :
+             {std::pair{&groupPaths, &built->groupPathViews},
+              std::pair{&ledNames, &built->ledNameViews}})
+        {
+            views->reserve(table->size());
+            for (size_t id = 0; id < table->size(); ++id)
+            {
+                const auto& name = table->name(id);
+                names.append(name);
+                views->emplace_back(names.data() + names.size() - name.size(),
+                                    name.size());
+            }
+        }
+
+        buildPerfectHash(built->groupPathViews, built->groupSeeds,
+                         built->groupSlots);
+        buildPerfectHash(built->ledNameViews, built->ledSeeds,
+                         built->ledSlots);
+
+        view.groupPaths = built->groupPathViews;
+        view.ledNames = built->ledNameViews;
+        view.members = built->members;
+        view.offsets = built->offsets;
+        view.groupIndex = {built->groupSeeds, built->groupSlots};
+        view.ledIndex = {built->ledSeeds, built->ledSlots};
+        storage = std::move(built);
+    }
+
+    /** @brief Tables of the layout built at runtime, shared by its copies.
+     *         Unset for a layout generated at build time.
+     */
+    std::shared_ptr<const Storage> storage;
+
+    /** @brief Views of the tables of the layout */
+    StaticLayout view;
+};
 } // namespace Layout
 } // namespace led
 } // namespace phosphor
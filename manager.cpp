@@ -9,97 +9,332 @@
 #include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
+
 namespace phosphor
 {
 namespace led
 {
 
-// Assert -or- De-assert
-bool Manager::setGroupState(const std::string& path, bool assert,
-                            group& ledsAssert, group& ledsDeAssert)
+Layout::NameId Manager::groupId(const std::string& path) const
 {
-    if (assert)
+    auto id = layout.findGroup(path);
+    if (!id)
     {
-        assertedGroups.insert(&ledMap.at(path));
+        throw std::out_of_range("Unknown LED group " + path);
     }
-    else
+    return *id;
+}
+
+Layout::LedAction Manager::toLedAction(const Layout::Member& member) const
+{
+    return {std::string(layout.ledName(member.led)), member.action,
+            member.dutyOn, member.period, member.priority};
+}
+
+// Action to be applied on the LED, honouring its priority
+const Layout::Member* Manager::LedRefCount::effective() const
+{
+    const Layout::Member* result = nullptr;
+
+    for (const auto& contributors : members)
     {
-        if (assertedGroups.contains(&ledMap.at(path)))
+        if (contributors.empty())
+        {
+            continue;
+        }
+
+        // Priority of an LED is the same across all groups, so any of the
+        // contributing members tells which action wins.
+        const auto* member = *contributors.begin();
+        if (member->action == member->priority)
         {
-            assertedGroups.erase(&ledMap.at(path));
+            return member;
+        }
+
+        if (result == nullptr)
+        {
+            result = member;
         }
     }
 
-    // This will contain the union of what's already in the asserted group
-    group desiredState{};
-    for (const auto& grp : assertedGroups)
+    return result;
+}
+
+// Same LEDs with the same actions, in the same order
+static bool sameMembers(const Layout::CompiledLayout& left,
+                        Layout::NameId leftGroup,
+                        const Layout::CompiledLayout& right,
+                        Layout::NameId rightGroup)
+{
+    auto leftMembers = left.groupMembers(leftGroup);
+    auto rightMembers = right.groupMembers(rightGroup);
+
+    return std::equal(leftMembers.begin(), leftMembers.end(),
+                      rightMembers.begin(), rightMembers.end(),
+                      [&](const auto& l, const auto& r) {
+        return left.ledName(l.led) == right.ledName(r.led) &&
+               l.action == r.action && l.dutyOn == r.dutyOn &&
+               l.period == r.period && l.priority == r.priority;
+    });
+}
+
+void Manager::reloadLayout(Layout::CompiledLayout newLayout, group& ledsAssert,
+                           group& ledsDeAssert)
+{
+    // The queued LED changes refer to the current layout
+    driveQueuedLeds();
+
+    // Asserted groups to re-evaluate, the other asserted groups are the same
+    // in both layouts.
+    std::vector<std::string> changed;
+    for (Layout::NameId id = 0; id < layout.groupCount(); ++id)
     {
-        desiredState.insert(grp->cbegin(), grp->cend());
+        auto newId = newLayout.findGroup(layout.groupPath(id));
+        if (assertedGroups[id] &&
+            (!newId || !sameMembers(layout, id, newLayout, *newId)))
+        {
+            changed.emplace_back(layout.groupPath(id));
+        }
     }
 
-    // Find difference between Combined and Desired to identify
-    // which LEDs are getting altered
-    group transient{};
-    std::set_difference(combinedState.begin(), combinedState.end(),
-                        desiredState.begin(), desiredState.end(),
-                        std::inserter(transient, transient.begin()), ledComp);
-    if (transient.size())
-    {
-        // Find common LEDs between transient and Desired to know if some LEDs
-        // are changing state and not really getting DeAsserted
-        group ledsTransient{};
-        std::set_intersection(
-            transient.begin(), transient.end(), desiredState.begin(),
-            desiredState.end(),
-            std::inserter(ledsTransient, ledsTransient.begin()), ledLess);
+    // Remember what the LEDs of these groups, in either layout, are showing
+    std::map<std::string, std::optional<Layout::LedAction>> before;
+    auto remember = [this, &before](std::string_view ledName) {
+        std::string name(ledName);
+        if (before.contains(name))
+        {
+            return;
+        }
+        auto led = layout.findLed(name);
+        const auto* current = led ? ledStates[*led].effective() : nullptr;
+        before.emplace(name, current ? std::optional(toLedAction(*current))
+                                     : std::nullopt);
+    };
 
-        // Find difference between above 2 to identify those LEDs which are
-        // really getting DeAsserted
-        std::set_difference(transient.begin(), transient.end(),
-                            ledsTransient.begin(), ledsTransient.end(),
-                            std::inserter(ledsDeAssert, ledsDeAssert.begin()),
-                            ledLess);
+    for (const auto& path : changed)
+    {
+        for (const auto& member : layout.groupMembers(groupId(path)))
+        {
+            remember(layout.ledName(member.led));
+        }
 
-        // Remove the elements from Current that are being DeAsserted.
-        if (ledsDeAssert.size())
+        if (auto newId = newLayout.findGroup(path))
         {
-            // Power off LEDs that are to be really DeAsserted
-            for (auto& it : ledsDeAssert)
+            for (const auto& member : newLayout.groupMembers(*newId))
             {
-                // Update LEDs in "physically asserted" set by removing those
-                // LEDs which are De-Asserted
-                auto found = currentState.find(it);
-                if (found != currentState.end())
-                {
-                    currentState.erase(found);
-                }
+                remember(newLayout.ledName(member.led));
             }
         }
     }
 
-    // Now LEDs that are to be Asserted. These could either be fresh asserts
-    // -or- change between [On]<-->[Blink]
-    group temp{};
-    std::unique_copy(desiredState.begin(), desiredState.end(),
-                     std::inserter(temp, temp.begin()), ledEqual);
-    if (temp.size())
+    // Take the changed groups out, so only unchanged groups are asserted
+    group unusedAssert;
+    group unusedDeAssert;
+    for (const auto& path : changed)
+    {
+        setGroupState(path, false, unusedAssert, unusedDeAssert);
+    }
+
+    // Carry the state of the unchanged groups over to the new layout
+    std::vector<bool> newAssertedGroups(newLayout.groupCount());
+    std::vector<LedRefCount> newLedStates(newLayout.ledCount());
+    for (Layout::NameId id = 0; id < layout.groupCount(); ++id)
+    {
+        if (!assertedGroups[id])
+        {
+            continue;
+        }
+
+        auto newId = *newLayout.findGroup(layout.groupPath(id));
+        newAssertedGroups[newId] = true;
+
+        for (const auto& member : newLayout.groupMembers(newId))
+        {
+            auto action = static_cast<size_t>(member.action);
+            newLedStates[member.led].members[action].insert(&member);
+        }
+    }
+
+    layout = std::move(newLayout);
+    assertedGroups = std::move(newAssertedGroups);
+    ledStates = std::move(newLedStates);
+
+    // Put the changed groups still in the layout back
+    for (const auto& path : changed)
+    {
+        if (layout.findGroup(path))
+        {
+            setGroupState(path, true, unusedAssert, unusedDeAssert);
+        }
+    }
+
+    // Drive the LEDs whose action differs from before the reload
+    for (const auto& [name, prev] : before)
     {
-        // Find difference between [desired to be Asserted] and those LEDs
-        // that are physically asserted currently.
-        std::set_difference(
-            temp.begin(), temp.end(), currentState.begin(), currentState.end(),
-            std::inserter(ledsAssert, ledsAssert.begin()), ledComp);
+        auto led = layout.findLed(name);
+        const auto* next = led ? ledStates[*led].effective() : nullptr;
+        if (next == nullptr)
+        {
+            if (prev)
+            {
+                ledsDeAssert.insert(*prev);
+            }
+            continue;
+        }
+
+        auto action = toLedAction(*next);
+        if (!prev || prev->action != action.action ||
+            prev->dutyOn != action.dutyOn || prev->period != action.period ||
+            prev->priority != action.priority)
+        {
+            ledsAssert.insert(action);
+        }
     }
+}
 
-    // Update the current actual and desired(the virtual actual)
-    currentState = std::move(temp);
-    combinedState = std::move(desiredState);
+// Assert -or- De-assert
+bool Manager::setGroupState(const std::string& path, bool assert,
+                            group& ledsAssert, group& ledsDeAssert)
+{
+    setGroupStates({{path, assert}}, ledsAssert, ledsDeAssert);
 
     // If we survive, then set the state accordingly.
     return assert;
 }
 
+void Manager::setGroupStates(const std::map<std::string, bool>& states,
+                             group& ledsAssert, group& ledsDeAssert)
+{
+    // Resolve all the groups first, so an unknown one changes nothing
+    std::vector<std::pair<Layout::NameId, bool>> changes;
+    for (const auto& [path, assert] : states)
+    {
+        auto id = groupId(path);
+
+        // Nothing changes unless the asserted state of the group flips
+        if (assertedGroups[id] != assert)
+        {
+            changes.emplace_back(id, assert);
+        }
+    }
+
+    // Remember what every member LED is showing before updating the
+    // reference counts, since only the LEDs of these groups can change.
+    LedSnapshot before;
+    for (const auto& [id, assert] : changes)
+    {
+        updateGroup(id, assert, before);
+    }
+
+    diffLeds(before, ledsAssert, ledsDeAssert);
+}
+
+bool Manager::queueGroupState(const std::string& path, bool assert)
+{
+    queueGroupStates({{path, assert}});
+    return assert;
+}
+
+void Manager::queueGroupStates(const std::map<std::string, bool>& states)
+{
+    // Resolve all the groups first, so an unknown one changes nothing
+    std::vector<std::pair<Layout::NameId, bool>> changes;
+    for (const auto& [path, assert] : states)
+    {
+        auto id = groupId(path);
+        if (assertedGroups[id] != assert)
+        {
+            changes.emplace_back(id, assert);
+        }
+    }
+
+    for (const auto& [id, assert] : changes)
+    {
+        updateGroup(id, assert, queuedLeds);
+    }
+
+    // The state of the physical LEDs being loaded, they are driven once it
+    // is known
+    if (!changes.empty() && physicalStatesReads == 0)
+    {
+        queueEvent.set_enabled(sdeventplus::source::Enabled::OneShot);
+    }
+}
+
+void Manager::takeQueuedLeds(group& ledsAssert, group& ledsDeAssert)
+{
+    diffLeds(queuedLeds, ledsAssert, ledsDeAssert);
+    queuedLeds.clear();
+}
+
+void Manager::driveQueuedLeds()
+{
+    queueEvent.set_enabled(sdeventplus::source::Enabled::Off);
+    if (queuedLeds.empty())
+    {
+        return;
+    }
+
+    group ledsAssert;
+    group ledsDeAssert;
+    takeQueuedLeds(ledsAssert, ledsDeAssert);
+    driveLEDs(ledsAssert, ledsDeAssert);
+}
+
+void Manager::updateGroup(Layout::NameId id, bool assert, LedSnapshot& before)
+{
+    assertedGroups[id] = assert;
+
+    for (const auto& member : layout.groupMembers(id))
+    {
+        auto& state = ledStates[member.led];
+        auto action = static_cast<size_t>(member.action);
+
+        // An LED of several groups keeps its state before any of them
+        // changed.
+        before.try_emplace(member.led, state.effective());
+
+        if (assert)
+        {
+            state.members[action].insert(&member);
+        }
+        else
+        {
+            state.members[action].erase(&member);
+        }
+    }
+}
+
+void Manager::diffLeds(const LedSnapshot& before, group& ledsAssert,
+                       group& ledsDeAssert) const
+{
+    // LEDs no longer part of any asserted group are DeAsserted, the ones
+    // that are newly asserted, change between [On]<-->[Blink] or blink with
+    // another timing are Asserted.
+    for (const auto& [led, prev] : before)
+    {
+        const auto* next = ledStates[led].effective();
+        if (next == nullptr)
+        {
+            if (prev != nullptr)
+            {
+                ledsDeAssert.insert(toLedAction(*prev));
+            }
+        }
+        else if (prev == nullptr || prev->action != next->action ||
+                 prev->dutyOn != next->dutyOn || prev->period != next->period)
+        {
+            ledsAssert.insert(toLedAction(*next));
+        }
+    }
+}
+
 void Manager::setLampTestCallBack(
     std::function<bool(group& ledsAssert, group& ledsDeAssert)> callBack)
 {
@@ -119,34 +354,29 @@ void Manager::driveLEDs(group& ledsAssert, group& ledsDeAssert)
     }
 #endif
     group newReqChangedLeds;
-    std::vector<std::pair<group&, group&>> actionsVec = {
-        {reqLedsAssert, ledsAssert}, {reqLedsDeAssert, ledsDeAssert}};
-
-    timer.setEnabled(false);
     std::set_union(ledsAssert.begin(), ledsAssert.end(), ledsDeAssert.begin(),
                    ledsDeAssert.end(),
                    std::inserter(newReqChangedLeds, newReqChangedLeds.begin()),
                    ledLess);
 
-    // prepare reqLedsAssert & reqLedsDeAssert
-    for (auto pair : actionsVec)
+    // Discard the LED actions waiting for a retry, if these LEDs have new
+    // actions in newReqChangedLeds.
+    for (auto* reqLeds : {&reqLedsAssert, &reqLedsDeAssert})
     {
         group tmpSet;
-
-        // Discard current required LED actions, if these LEDs have new actions
-        // in newReqChangedLeds.
-        std::set_difference(pair.first.begin(), pair.first.end(),
+        std::set_difference(reqLeds->begin(), reqLeds->end(),
                             newReqChangedLeds.begin(), newReqChangedLeds.end(),
                             std::inserter(tmpSet, tmpSet.begin()), ledLess);
+        *reqLeds = std::move(tmpSet);
+    }
 
-        // Union the remaining LED actions with new LED actions.
-        pair.first.clear();
-        std::set_union(tmpSet.begin(), tmpSet.end(), pair.second.begin(),
-                       pair.second.end(),
-                       std::inserter(pair.first, pair.first.begin()), ledLess);
+    for (const auto& led : newReqChangedLeds)
+    {
+        retries.reset(led.name);
     }
+    armRetryTimer();
 
-    driveLedsHandler();
+    sendLeds(ledsAssert, ledsDeAssert);
     return;
 }
 
@@ -176,45 +406,319 @@ static bool isSysfsPresentForPSU(const std::string& phyLedPath)
     return false;
 }
 
+/**
+ * @brief Checks if a failure to drive a physical LED is worth an error log
+ *
+ * @param[in] objPath - physical LED object path.
+ *
+ * @return false for PSU LEDs whose driver is not present in sysfs.
+ */
+static bool isDriveErrorLogged(const std::string& objPath)
+{
+    // For PSU, if the given driver is not present in sysfs path and
+    // set-property call fails, do not log error.
+    return (objPath.find("cffps") == std::string::npos) ||
+           isSysfsPresentForPSU(objPath);
+}
+
 // Calls into driving physical LED post choosing the action
 int Manager::drivePhysicalLED(const std::string& objPath, Layout::Action action,
                               uint8_t dutyOn, const uint16_t period)
 {
-    try
+    auto properties = getChangedProperties(physicalStates[objPath], action,
+                                           dutyOn, period);
+
+    for (const auto& property : properties)
     {
-        // If Blink, set its property
-        if (action == Layout::Action::Blink)
+        try
+        {
+            dBusHandler.setProperty(objPath, PHY_LED_IFACE, property.first,
+                                    property.second);
+        }
+        catch (const std::exception& e)
         {
-            PropertyValue dutyOnValue{dutyOn};
-            PropertyValue periodValue{period};
+            updatePhysicalState(objPath, property, false);
 
-            dBusHandler.setProperty(objPath, PHY_LED_IFACE, "DutyOn",
-                                    dutyOnValue);
-            dBusHandler.setProperty(objPath, PHY_LED_IFACE, "Period",
-                                    periodValue);
+            if (isDriveErrorLogged(objPath))
+            {
+                lg2::error(
+                    "Error setting property for physical LED, ERROR = {ERROR}, OBJECT_PATH = {PATH}",
+                    "ERROR", e, "PATH", objPath);
+            }
+
+            return -1;
         }
 
-        PropertyValue actionValue{getPhysicalAction(action)};
-        dBusHandler.setProperty(objPath, PHY_LED_IFACE, "State", actionValue);
+        updatePhysicalState(objPath, property, true);
+    }
+
+    return 0;
+}
+
+Manager::PhysicalProperties
+    Manager::getChangedProperties(const PropertyMap& state,
+                                  Layout::Action action, uint8_t dutyOn,
+                                  uint16_t period)
+{
+    PhysicalProperties properties;
+
+    // If Blink, set its property
+    if (action == Layout::Action::Blink)
+    {
+        properties.emplace_back("DutyOn", dutyOn);
+        properties.emplace_back("Period", period);
+    }
+    properties.emplace_back("State", getPhysicalAction(action));
+
+    std::erase_if(properties, [&state](const auto& property) {
+        auto iter = state.find(property.first);
+        return iter != state.end() && iter->second == property.second;
+    });
+
+    return properties;
+}
+
+void Manager::updatePhysicalState(
+    const std::string& objPath,
+    const std::pair<std::string, PropertyValue>& property, bool success)
+{
+    auto& state = physicalStates[objPath];
+    if (success)
+    {
+        state.insert_or_assign(property.first, property.second);
+    }
+    else
+    {
+        state.erase(property.first);
+    }
+}
+
+void Manager::loadPhysicalStates()
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    // Watch the changes before reading the state, not to miss any
+    physicalStatesMatches.emplace_back(
+        bus, rules::propertiesChangedNamespace(PHY_LED_ROOT, PHY_LED_IFACE),
+        [this](sdbusplus::message_t& msg) {
+        std::string interface;
+        PropertyMap properties;
+        try
+        {
+            msg.read(interface, properties);
+        }
+        catch (const sdbusplus::exception::exception& e)
+        {
+            lg2::error("Failed to read PropertiesChanged, ERROR = {ERROR}",
+                       "ERROR", e);
+            return;
+        }
+
+        updatePhysicalStates(msg.get_sender(), msg.get_path(), properties);
+    });
+
+    // LEDs added later report their state as they come
+    physicalStatesMatches.emplace_back(
+        bus, rules::interfacesAdded(), [this](sdbusplus::message_t& msg) {
+        sdbusplus::message::object_path path;
+        std::map<std::string, PropertyMap> interfaces;
+        try
+        {
+            msg.read(path, interfaces);
+        }
+        catch (const sdbusplus::exception::exception& e)
+        {
+            lg2::error("Failed to read InterfacesAdded, ERROR = {ERROR}",
+                       "ERROR", e);
+            return;
+        }
+
+        auto iter = interfaces.find(PHY_LED_IFACE);
+        if (iter != interfaces.end())
+        {
+            updatePhysicalStates(msg.get_sender(), path.str, iter->second);
+        }
+    });
+
+    physicalStatesMatches.emplace_back(
+        bus, rules::interfacesRemoved(), [this](sdbusplus::message_t& msg) {
+        sdbusplus::message::object_path path;
+        std::vector<std::string> interfaces;
+        try
+        {
+            msg.read(path, interfaces);
+        }
+        catch (const sdbusplus::exception::exception& e)
+        {
+            lg2::error("Failed to read InterfacesRemoved, ERROR = {ERROR}",
+                       "ERROR", e);
+            return;
+        }
+
+        if (std::ranges::find(interfaces, PHY_LED_IFACE) != interfaces.end())
+        {
+            removePhysicalState(path.str);
+        }
+    });
+
+    // A restarted service does not keep the state of its LEDs
+    physicalStatesMatches.emplace_back(
+        bus, rules::nameOwnerChanged(), [this](sdbusplus::message_t& msg) {
+        std::string name;
+        std::string oldOwner;
+        std::string newOwner;
+        try
+        {
+            msg.read(name, oldOwner, newOwner);
+        }
+        catch (const sdbusplus::exception::exception& e)
+        {
+            lg2::error("Failed to read NameOwnerChanged, ERROR = {ERROR}",
+                       "ERROR", e);
+            return;
+        }
+
+        if (!oldOwner.empty())
+        {
+            removePhysicalStates(name);
+        }
+    });
+
+    // The LEDs whose state is not known are written as before
+    ++physicalStatesReads;
+    try
+    {
+        physicalStatesSlots.emplace_back(dBusHandler.getSubTreeServicesAsync(
+            PHY_LED_ROOT, PHY_LED_IFACE,
+            [this](const std::vector<std::string>& services, int error) {
+            physicalServicesHandler(services, error);
+        }));
     }
     catch (const std::exception& e)
     {
-        // For PSU, if the given driver is not present in sysfs path and
-        // set-property call fails, do not log error.
-        if ((objPath.find("cffps") != std::string::npos) &&
-            (!isSysfsPresentForPSU(objPath)))
+        lg2::error(
+            "Failed to read the state of the physical LEDs, ERROR = {ERROR}",
+            "ERROR", e);
+        physicalStatesRead();
+    }
+}
+
+void Manager::physicalServicesHandler(const std::vector<std::string>& services,
+                                      int error)
+{
+    if (error)
+    {
+        lg2::error(
+            "Failed to read the state of the physical LEDs, ERRNO = {ERRNO}",
+            "ERRNO", error);
+    }
+
+    // One GetManagedObjects per LED controller service, a failing service
+    // does not keep the others from being read
+    for (const auto& service : services)
+    {
+        try
         {
-            return -1;
+            physicalStatesSlots.emplace_back(dBusHandler.getManagedObjectsAsync(
+                service, PHY_LED_ROOT,
+                [this, service](const ManagedObjects& objects, int error) {
+                physicalObjectsHandler(service, objects, error);
+            }));
+            ++physicalStatesReads;
+        }
+        catch (const std::exception& e)
+        {
+            lg2::error(
+                "Failed to read the state of the physical LEDs, SERVICE = {SERVICE}, ERROR = {ERROR}",
+                "SERVICE", service, "ERROR", e);
         }
+    }
+
+    physicalStatesRead();
+}
 
+void Manager::physicalObjectsHandler(const std::string& service,
+                                     const ManagedObjects& objects, int error)
+{
+    if (error)
+    {
         lg2::error(
-            "Error setting property for physical LED, ERROR = {ERROR}, OBJECT_PATH = {PATH}",
-            "ERROR", e, "PATH", objPath);
+            "Failed to read the state of the physical LEDs, SERVICE = {SERVICE}, ERRNO = {ERRNO}",
+            "SERVICE", service, "ERRNO", error);
+    }
 
-        return -1;
+    for (const auto& [path, interfaces] : objects)
+    {
+        auto iter = interfaces.find(PHY_LED_IFACE);
+        if (iter != interfaces.end())
+        {
+            updatePhysicalStates(service, path, iter->second);
+        }
     }
 
-    return 0;
+    physicalStatesRead();
+}
+
+void Manager::physicalStatesRead()
+{
+    // The restored groups held back while loading are driven now
+    if (--physicalStatesReads == 0 && !queuedLeds.empty())
+    {
+        queueEvent.set_enabled(sdeventplus::source::Enabled::OneShot);
+    }
+}
+
+void Manager::updatePhysicalStates(const std::string& service,
+                                   const std::string& objPath,
+                                   const PropertyMap& properties)
+{
+    std::string_view name(objPath);
+    if (!name.starts_with(PHY_LED_PATH))
+    {
+        return;
+    }
+    name.remove_prefix(std::string_view(PHY_LED_PATH).size());
+
+    if (!service.empty())
+    {
+        physicalStateOwners[service].insert(objPath);
+    }
+
+    // The signals of our own writes arrive before their replies
+    if (latestRequests.contains(std::string(name)))
+    {
+        return;
+    }
+
+    auto& state = physicalStates[objPath];
+    for (const auto* property : {"State", "DutyOn", "Period"})
+    {
+        auto iter = properties.find(property);
+        if (iter != properties.end())
+        {
+            state.insert_or_assign(iter->first, iter->second);
+        }
+    }
+}
+
+void Manager::removePhysicalState(const std::string& objPath)
+{
+    physicalStates.erase(objPath);
+}
+
+void Manager::removePhysicalStates(const std::string& service)
+{
+    auto iter = physicalStateOwners.find(service);
+    if (iter == physicalStateOwners.end())
+    {
+        return;
+    }
+
+    for (const auto& objPath : iter->second)
+    {
+        physicalStates.erase(objPath);
+    }
+    physicalStateOwners.erase(iter);
 }
 
 /** @brief Returns action string based on enum */
@@ -241,50 +745,196 @@ std::string Manager::getPhysicalAction(Layout::Action action)
 
 void Manager::driveLedsHandler(void)
 {
-    group failedLedsAssert;
-    group failedLedsDeAssert;
+    group ledsAssert;
+    group ledsDeAssert;
 
-    // This order of LED operation is important.
-    if (reqLedsDeAssert.size())
+    // Take the LEDs whose backoff expired out of the retry sets
+    for (const auto& name : retries.expired(RetryScheduler::Clock::now()))
     {
-        for (const auto& it : reqLedsDeAssert)
+        for (auto [from, to] : {std::pair{&reqLedsAssert, &ledsAssert},
+                                std::pair{&reqLedsDeAssert, &ledsDeAssert}})
         {
-            std::string objPath = std::string(PHY_LED_PATH) + it.name;
-            lg2::debug("De-Asserting LED, NAME = {NAME}", "NAME", it.name);
-            if (drivePhysicalLED(objPath, Layout::Action::Off, it.dutyOn,
-                                 it.period))
+            auto iter = std::find_if(
+                from->begin(), from->end(),
+                [&name](const auto& led) { return led.name == name; });
+            if (iter != from->end())
             {
-                failedLedsDeAssert.insert(it);
+                to->insert(from->extract(iter));
             }
         }
     }
 
-    if (reqLedsAssert.size())
+    sendLeds(ledsAssert, ledsDeAssert);
+    armRetryTimer();
+
+    return;
+}
+
+void Manager::sendLeds(const group& ledsAssert, const group& ledsDeAssert)
+{
+    // Calls completed since the last batch can be released now that we are
+    // out of their reply callbacks.
+    completedSlots.clear();
+
+    // This order of LED operation is important. D-Bus delivers the calls
+    // to a service in the order they are sent, so sending the DeAsserts
+    // first keeps the Set calls of every LED in request order even though
+    // none of them waits for a reply.
+    for (const auto& it : ledsDeAssert)
+    {
+        lg2::debug("De-Asserting LED, NAME = {NAME}", "NAME", it.name);
+        drivePhysicalLEDAsync(it, true);
+    }
+
+    for (const auto& it : ledsAssert)
+    {
+        lg2::debug("Asserting LED, NAME = {NAME}", "NAME", it.name);
+        drivePhysicalLEDAsync(it, false);
+    }
+}
+
+void Manager::armRetryTimer()
+{
+    auto deadline = retries.nextDeadline();
+    if (!deadline)
     {
-        for (const auto& it : reqLedsAssert)
+        timer.setEnabled(false);
+        return;
+    }
+
+    auto now = RetryScheduler::Clock::now();
+    auto timeout = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::max(*deadline - now, RetryScheduler::Clock::duration::zero()));
+    timer.restartOnce(timeout);
+}
+
+void Manager::drivePhysicalLEDAsync(const Layout::LedAction& led,
+                                    bool deAssert)
+{
+    auto request = nextRequest++;
+    latestRequests[led.name] = request;
+
+    auto iter =
+        pendingLeds
+            .emplace(request, PendingLed{led, deAssert, {}, 0, false, {}})
+            .first;
+    auto& pending = iter->second;
+
+    std::string objPath = std::string(PHY_LED_PATH) + led.name;
+    auto action = deAssert ? Layout::Action::Off : led.action;
+
+    // Only the properties not already holding the wanted value are written
+    pending.properties = getChangedProperties(physicalStates[objPath], action,
+                                              led.dutyOn, led.period);
+
+    try
+    {
+        for (size_t index = 0; index < pending.properties.size(); ++index)
         {
-            std::string objPath = std::string(PHY_LED_PATH) + it.name;
-            lg2::debug("Asserting LED, NAME = {NAME}", "NAME", it.name);
-            if (drivePhysicalLED(objPath, it.action, it.dutyOn, it.period))
-            {
-                failedLedsAssert.insert(it);
-            }
+            const auto& [property, value] = pending.properties[index];
+            pending.slots.emplace_back(dBusHandler.setPropertyAsync(
+                objPath, PHY_LED_IFACE, property, value,
+                [this, request, index](sdbusplus::message_t& reply) {
+                    physicalLEDReplyHandler(request, index, reply);
+                }));
+            ++pending.outstanding;
+
+            updatePhysicalState(objPath, pending.properties[index], true);
         }
     }
+    catch (const std::exception& e)
+    {
+        if (isDriveErrorLogged(objPath))
+        {
+            lg2::error(
+                "Error setting property for physical LED, ERROR = {ERROR}, OBJECT_PATH = {PATH}",
+                "ERROR", e, "PATH", objPath);
+        }
+        pending.failed = true;
 
-    reqLedsAssert = failedLedsAssert;
-    reqLedsDeAssert = failedLedsDeAssert;
+        // Whatever could not be sent is no longer known to hold its value
+        for (size_t index = pending.outstanding;
+             index < pending.properties.size(); ++index)
+        {
+            updatePhysicalState(objPath, pending.properties[index], false);
+        }
+    }
 
-    if (reqLedsDeAssert.empty() && reqLedsAssert.empty())
+    if (pending.outstanding == 0)
     {
-        timer.setEnabled(false);
+        completeRequest(iter);
     }
-    else
+}
+
+void Manager::physicalLEDReplyHandler(uint64_t request, size_t index,
+                                      sdbusplus::message_t& reply)
+{
+    auto iter = pendingLeds.find(request);
+    if (iter == pendingLeds.end())
     {
-        timer.restartOnce(std::chrono::seconds(1));
+        return;
     }
 
-    return;
+    auto& pending = iter->second;
+    if (reply.is_method_error())
+    {
+        std::string objPath = std::string(PHY_LED_PATH) + pending.led.name;
+        updatePhysicalState(objPath, pending.properties[index], false);
+
+        if (!pending.failed && isDriveErrorLogged(objPath))
+        {
+            lg2::error(
+                "Error setting property for physical LED, ERRNO = {ERRNO}, OBJECT_PATH = {PATH}",
+                "ERRNO", reply.get_errno(), "PATH", objPath);
+        }
+        pending.failed = true;
+    }
+
+    if (--pending.outstanding == 0)
+    {
+        completeRequest(iter);
+    }
+}
+
+void Manager::completeRequest(std::map<uint64_t, PendingLed>::iterator iter)
+{
+    auto& [request, pending] = *iter;
+
+    // Only the latest request of an LED is retried, a newer one has already
+    // superseded the failed action.
+    auto latest = latestRequests.find(pending.led.name);
+    if (latest != latestRequests.end() && latest->second == request)
+    {
+        latestRequests.erase(latest);
+
+        if (!pending.failed)
+        {
+            retries.reset(pending.led.name);
+        }
+        else if (retries.failed(pending.led.name,
+                                RetryScheduler::Clock::now()))
+        {
+            lg2::info(
+                "Retrying physical LED, NAME = {NAME}, ATTEMPTS = {ATTEMPTS}",
+                "NAME", pending.led.name, "ATTEMPTS",
+                retries.getLeds().at(pending.led.name).attempts);
+
+            auto& retry = pending.deAssert ? reqLedsDeAssert : reqLedsAssert;
+            retry.insert(pending.led);
+            armRetryTimer();
+        }
+        else
+        {
+            lg2::error(
+                "Giving up driving physical LED, NAME = {NAME}, ATTEMPTS = {ATTEMPTS}, EXHAUSTED = {EXHAUSTED}",
+                "NAME", pending.led.name, "ATTEMPTS", RETRY_MAX_ATTEMPTS,
+                "EXHAUSTED", retries.getExhaustedCount());
+        }
+    }
+
+    std::move(pending.slots.begin(), pending.slots.end(),
+              std::back_inserter(completedSlots));
+    pendingLeds.erase(iter);
 }
 } // namespace led
 } // namespace phosphor
@@ -1,14 +1,19 @@
 #pragma once
 
 #include "ledlayout.hpp"
+#include "retry-scheduler.hpp"
 #include "utils.hpp"
 
 #include <sdeventplus/event.hpp>
+#include <sdeventplus/source/event.hpp>
 #include <sdeventplus/utility/timer.hpp>
 
+#include <array>
+#include <chrono>
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace phosphor
 {
@@ -16,9 +21,15 @@ namespace led
 {
 using namespace phosphor::led::utils;
 
+static constexpr auto PHY_LED_ROOT = "/xyz/openbmc_project/led/physical";
 static constexpr auto PHY_LED_PATH = "/xyz/openbmc_project/led/physical/";
 static constexpr auto PHY_LED_IFACE = "xyz.openbmc_project.Led.Physical";
 
+/** @brief Backoff of the retries of failed physical LED requests */
+static constexpr auto RETRY_INITIAL_DELAY = std::chrono::seconds(1);
+static constexpr auto RETRY_MAX_DELAY = std::chrono::minutes(5);
+static constexpr unsigned RETRY_MAX_ATTEMPTS = 10;
+
 /** @class Manager
  *  @brief Manages group of LEDs and applies action on the elements of group
  */
@@ -33,30 +44,6 @@ class Manager
     Manager(Manager&&) = delete;
     Manager& operator=(Manager&&) = delete;
 
-    /** @brief Special comparator for finding set difference */
-    static bool ledComp(const phosphor::led::Layout::LedAction& left,
-                        const phosphor::led::Layout::LedAction& right)
-    {
-        // Example :
-        // If FIRST_1 is {fan0, 1, 1} and FIRST_2 is {fan0, 2, 2},
-        // with default priority of Blink, this comparator would return
-        // false. But considering the priority, this comparator would need
-        // to return true so that we consider appropriate set and in
-        // this case its {fan0, 1, 1}
-        if (left.name == right.name)
-        {
-            if (left.action == right.action)
-            {
-                return false;
-            }
-            else
-            {
-                return true;
-            }
-        }
-        return left.name < right.name;
-    }
-
     /** @brief Comparator for finding LEDs to be DeAsserted */
     static bool ledLess(const phosphor::led::Layout::LedAction& left,
                         const phosphor::led::Layout::LedAction& right)
@@ -64,32 +51,31 @@ class Manager
         return left.name < right.name;
     }
 
-    /** @brief Comparator for helping unique_copy */
-    static bool ledEqual(const phosphor::led::Layout::LedAction& left,
-                         const phosphor::led::Layout::LedAction& right)
-    {
-        return left.name == right.name;
-    }
-
     using group = std::set<phosphor::led::Layout::LedAction>;
-    using LedLayout = std::map<std::string, group>;
+    using LedLayout = Layout::GroupMap;
 
-    /** @brief static global map constructed at compile time */
-    const LedLayout& ledMap;
+    /** @brief Ordered list of physical LED properties to be written */
+    using PhysicalProperties =
+        std::vector<std::pair<std::string, PropertyValue>>;
 
     /** @brief Refer the user supplied LED layout and sdbusplus handler
      *
      *  @param [in] bus       - sdbusplus handler
-     *  @param [in] LedLayout - LEDs group layout
+     *  @param [in] ledLayout - LEDs group layout, compiled by the caller or
+     *                          converted from a LedLayout
      *  @param [in] Event    - sd event handler
      */
     Manager(
-        sdbusplus::bus_t& bus, const LedLayout& ledLayout,
+        sdbusplus::bus_t& bus, Layout::CompiledLayout ledLayout,
         const sdeventplus::Event& event = sdeventplus::Event::get_default()) :
-        ledMap(ledLayout),
-        bus(bus), timer(event, [this](auto&) { driveLedsHandler(); })
+        layout(std::move(ledLayout)),
+        bus(bus), assertedGroups(layout.groupCount()),
+        ledStates(layout.ledCount()),
+        timer(event, [this](auto&) { driveLedsHandler(); }),
+        queueEvent(event, [this](auto&) { driveQueuedLeds(); }),
+        retries(RETRY_INITIAL_DELAY, RETRY_MAX_DELAY, RETRY_MAX_ATTEMPTS)
     {
-        // Nothing here
+        queueEvent.set_enabled(sdeventplus::source::Enabled::Off);
     }
 
     /** @brief Given a group name, applies the action on the group
@@ -105,6 +91,57 @@ class Manager
     bool setGroupState(const std::string& path, bool assert, group& ledsAssert,
                        group& ledsDeAssert);
 
+    /** @brief Applies the asserted state of several groups at once. The
+     *         LEDs to drive are the difference between the LED states
+     *         before and after all the changes.
+     *
+     *  @param[in]  states        -  asserted state, keyed by dbus path of
+     *                               group
+     *  @param[in]  ledsAssert    -  LEDs that are to be asserted new
+     *                               or to a different state
+     *  @param[in]  ledsDeAssert  -  LEDs that are to be Deasserted
+     *
+     *  std::out_of_range thrown, changing nothing, if a group is unknown
+     */
+    void setGroupStates(const std::map<std::string, bool>& states,
+                        group& ledsAssert, group& ledsDeAssert);
+
+    /** @brief Applies the asserted state of a group now, and drives its
+     *         LEDs at the end of the current event loop dispatch, with the
+     *         other groups queued meanwhile. Only the net change of every
+     *         LED is driven, an LED changing back within the batch is left
+     *         untouched.
+     *
+     *  @param[in]  path    -  dbus path of group
+     *  @param[in]  assert  -  Could be true or false
+     *
+     *  @return             -  Success or exception thrown
+     */
+    bool queueGroupState(const std::string& path, bool assert);
+
+    /** @brief Applies the asserted state of several groups now, and drives
+     *         their LEDs along with the other queued groups, see
+     *         queueGroupState(). While the state of the physical LEDs is
+     *         being loaded, they are driven once it is known.
+     *
+     *  @param[in]  states  -  asserted state, keyed by dbus path of group
+     *
+     *  std::out_of_range thrown, changing nothing, if a group is unknown
+     */
+    void queueGroupStates(const std::map<std::string, bool>& states);
+
+    /** @brief Returns the net LED changes of the queued groups and starts a
+     *         new batch, without driving them.
+     *
+     *  @param[in]  ledsAssert    -  LEDs that are to be asserted new
+     *                               or to a different state
+     *  @param[in]  ledsDeAssert  -  LEDs that are to be Deasserted
+     */
+    void takeQueuedLeds(group& ledsAssert, group& ledsDeAssert);
+
+    /** @brief Drives the net LED changes of the queued groups now */
+    void driveQueuedLeds();
+
     /** @brief Finds the set of LEDs to operate on and executes action
      *
      *  @param[in]  ledsAssert    -  LEDs that are to be asserted newly
@@ -128,6 +165,63 @@ class Manager
     int drivePhysicalLED(const std::string& objPath, Layout::Action action,
                          uint8_t dutyOn, const uint16_t period);
 
+    /** @brief Returns the physical LED properties to write for an action,
+     *         leaving out the ones already holding the wanted value.
+     *
+     *  @param[in]  state     -  Last written properties of the LED
+     *  @param[in]  action    -  Intended action to be triggered
+     *  @param[in]  dutyOn    -  Duty Cycle ON percentage
+     *  @param[in]  period    -  Time taken for one blink cycle
+     *
+     *  @return               -  Properties to be written, in write order
+     */
+    static PhysicalProperties getChangedProperties(const PropertyMap& state,
+                                                   Layout::Action action,
+                                                   uint8_t dutyOn,
+                                                   uint16_t period);
+
+    /** @brief Starts reading the state of the physical LEDs from their
+     *         services and keeps it up to date from their signals, so LEDs
+     *         already in the wanted state are not written. The reads do not
+     *         block the event loop.
+     */
+    void loadPhysicalStates();
+
+    /** @brief Records the properties of a physical LED reported by its
+     *         service. Ignored while requests on the LED are in flight,
+     *         their values are already recorded.
+     *
+     *  @param[in]  service     -  D-Bus service hosting the LED
+     *  @param[in]  objPath     -  D-Bus object path
+     *  @param[in]  properties  -  properties of the Physical interface
+     */
+    void updatePhysicalStates(const std::string& service,
+                              const std::string& objPath,
+                              const PropertyMap& properties);
+
+    /** @brief Forgets the state of a physical LED, e.g. once its object is
+     *         removed. The LED is written in full the next time it is
+     *         driven.
+     *
+     *  @param[in]  objPath  -  D-Bus object path
+     */
+    void removePhysicalState(const std::string& objPath);
+
+    /** @brief Forgets the state of the physical LEDs of a service, e.g.
+     *         once it exits or restarts.
+     *
+     *  @param[in]  service  -  D-Bus service name
+     */
+    void removePhysicalStates(const std::string& service);
+
+    /** @brief Last known properties of the physical LEDs, keyed by object
+     *         path
+     */
+    const std::map<std::string, PropertyMap>& getPhysicalStates() const
+    {
+        return physicalStates;
+    }
+
     /** @brief Set lamp test callback when enabled lamp test.
      *
      *  @param[in]  callBack   -  Custom callback when enabled lamp test
@@ -143,29 +237,73 @@ class Manager
      */
     bool isAsserted(const std::string& path) const
     {
-        return assertedGroups.contains(&ledMap.at(path));
+        return assertedGroups[groupId(path)];
+    }
+
+    /** @brief Compiled LED layout the groups are managed from */
+    const Layout::CompiledLayout& getLayout() const
+    {
+        return layout;
+    }
+
+    /** @brief Replaces the LED layout, e.g. after the config changed.
+     *
+     *  Groups keep their asserted state when they are still in the new
+     *  layout. Only the LEDs of the asserted groups that are removed or
+     *  whose members changed are re-evaluated.
+     *
+     *  @param[in]  newLayout     -  LEDs group layout to use
+     *  @param[in]  ledsAssert    -  LEDs that are to be asserted new
+     *                               or to a different state
+     *  @param[in]  ledsDeAssert  -  LEDs that are to be Deasserted
+     */
+    void reloadLayout(Layout::CompiledLayout newLayout, group& ledsAssert,
+                      group& ledsDeAssert);
+
+    /** @brief Retry state of the physical LEDs failing to be driven */
+    const RetryScheduler& getRetries() const
+    {
+        return retries;
     }
 
   private:
+    /** @brief Compiled LED layout the groups are managed from */
+    Layout::CompiledLayout layout;
+
     /** @brief sdbusplus handler */
     sdbusplus::bus::bus& bus;
 
-    /** Map of physical LED path to service name */
-    std::map<std::string, std::string> phyLeds{};
-
     /** DBusHandler class handles the D-Bus operations */
     DBusHandler dBusHandler;
 
-    /** @brief Pointers to groups that are in asserted state */
-    std::set<const group*> assertedGroups;
-
-    /** @brief Contains the highest priority actions for all
-     *         asserted LEDs.
+    /** @brief Asserted group members requesting each action on a physical
+     *         LED.
+     *
+     *  The action applied to the LED is its priority action when at least
+     *  one asserted group requests it, otherwise any other requested action.
      */
-    group currentState;
+    struct LedRefCount
+    {
+        /** @brief Contributing members indexed by Layout::Action. Members
+         *         are laid out in group order, so the first one is that of
+         *         the first asserted group and gives the DutyOn and Period
+         *         of the action.
+         */
+        std::array<std::set<const Layout::Member*>, 3> members{};
+
+        /** @brief Returns the member whose action must be applied to the
+         *         LED, or nullptr if no asserted group contains the LED.
+         */
+        const Layout::Member* effective() const;
+    };
 
-    /** @brief Contains the set of all actions for asserted LEDs */
-    group combinedState;
+    /** @brief Asserted state of every group, indexed by group id */
+    std::vector<bool> assertedGroups;
+
+    /** @brief Reference counted state of every physical LED, indexed by
+     *         LED id.
+     */
+    std::vector<LedRefCount> ledStates;
 
     /** @brief Custom callback when enabled lamp test */
     std::function<bool(group& ledsAssert, group& ledsDeAssert)>
@@ -174,15 +312,195 @@ class Manager
     /** @brief Timer used for LEDs handler callback*/
     sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic> timer;
 
-    /** @brief Contains the required set of assert LEDs action */
+    /** @brief Deferred event driving the queued LED changes */
+    sdeventplus::source::Defer queueEvent;
+
+    /** @brief Effective member of LEDs before a change, keyed by LED id */
+    using LedSnapshot = std::map<Layout::NameId, const Layout::Member*>;
+
+    /** @brief State of the LEDs of the queued groups before the batch */
+    LedSnapshot queuedLeds;
+
+    /** @brief Backoff of the LEDs waiting for a retry */
+    RetryScheduler retries;
+
+    /** @brief Contains the assert LEDs action waiting for a retry */
     group reqLedsAssert;
 
-    /** @brief Contains the required set of deassert LEDs action */
+    /** @brief Contains the deassert LEDs action waiting for a retry */
     group reqLedsDeAssert;
 
-    /** @brief LEDs handler callback */
+    /** @brief Set calls in flight for one request on a physical LED */
+    struct PendingLed
+    {
+        /** @brief Requested LED action */
+        Layout::LedAction led;
+
+        /** @brief The LED is being DeAsserted */
+        bool deAssert;
+
+        /** @brief Properties being written, in the order of the calls */
+        PhysicalProperties properties;
+
+        /** @brief Number of Set calls waiting for their reply */
+        size_t outstanding;
+
+        /** @brief At least one of the Set calls failed */
+        bool failed;
+
+        /** @brief Slots of the Set calls */
+        std::vector<sdbusplus::slot_t> slots;
+    };
+
+    /** @brief Last written properties of each physical LED, keyed by
+     *         object path. Values are recorded when the Set call is sent,
+     *         as calls are applied in order, and a property is dropped when
+     *         its value is not known, e.g. after a failed write.
+     */
+    std::map<std::string, PropertyMap> physicalStates;
+
+    /** @brief Object paths of the physical LEDs known to each service, to
+     *         forget their state when the service goes away
+     */
+    std::map<std::string, std::set<std::string>> physicalStateOwners;
+
+    /** @brief Matches keeping the state of the physical LEDs up to date,
+     *         set once their state is loaded
+     */
+    std::vector<sdbusplus::bus::match_t> physicalStatesMatches;
+
+    /** @brief Calls reading the state of the physical LEDs */
+    std::vector<sdbusplus::slot_t> physicalStatesSlots;
+
+    /** @brief Number of calls reading the state of the physical LEDs not
+     *         replied yet
+     */
+    size_t physicalStatesReads = 0;
+
+    /** @brief Requests in flight, keyed by request sequence number */
+    std::map<uint64_t, PendingLed> pendingLeds;
+
+    /** @brief Sequence number of the latest request in flight for each
+     *         physical LED, keyed by LED name
+     */
+    std::map<std::string, uint64_t> latestRequests;
+
+    /** @brief Sequence number of the next request */
+    uint64_t nextRequest{0};
+
+    /** @brief Slots of completed Set calls. A slot can't be released from
+     *         its own reply callback, so they are released on the next
+     *         batch.
+     */
+    std::vector<sdbusplus::slot_t> completedSlots;
+
+    /** @brief LEDs handler callback, retries the LEDs whose backoff expired
+     */
     void driveLedsHandler();
 
+    /** @brief Sends a batch of LED actions
+     *
+     *  @param[in]  ledsAssert    -  LEDs that are to be asserted
+     *  @param[in]  ledsDeAssert  -  LEDs that are to be Deasserted
+     */
+    void sendLeds(const group& ledsAssert, const group& ledsDeAssert);
+
+    /** @brief Arms the timer for the earliest retry deadline */
+    void armRetryTimer();
+
+    /** @brief Sends the Set calls applying an action on a physical LED
+     *         without waiting for their replies.
+     *
+     *  @param[in]  led       -  LED action
+     *  @param[in]  deAssert  -  true: turn the LED Off
+     */
+    void drivePhysicalLEDAsync(const Layout::LedAction& led, bool deAssert);
+
+    /** @brief Handles the services of the physical LEDs, reading the state
+     *         of the LEDs of each of them
+     *
+     *  @param[in]  services  -  D-Bus services hosting physical LEDs
+     *  @param[in]  error     -  errno of the failed call, 0 on success
+     */
+    void physicalServicesHandler(const std::vector<std::string>& services,
+                                 int error);
+
+    /** @brief Handles the objects of a physical LED service, recording the
+     *         state of its LEDs
+     *
+     *  @param[in]  service  -  D-Bus service name
+     *  @param[in]  objects  -  objects of the service
+     *  @param[in]  error    -  errno of the failed call, 0 on success
+     */
+    void physicalObjectsHandler(const std::string& service,
+                                const ManagedObjects& objects, int error);
+
+    /** @brief Accounts for a completed read of the physical LED state,
+     *         driving the held back queued LEDs after the last one
+     */
+    void physicalStatesRead();
+
+    /** @brief Handles the reply of a Set call sent by drivePhysicalLEDAsync
+     *
+     *  @param[in]  request  -  sequence number of the request
+     *  @param[in]  index    -  index of the property in the request
+     *  @param[in]  reply    -  reply message
+     */
+    void physicalLEDReplyHandler(uint64_t request, size_t index,
+                                 sdbusplus::message_t& reply);
+
+    /** @brief Records the outcome of a physical LED property write
+     *
+     *  @param[in]  objPath   -  D-Bus object path
+     *  @param[in]  property  -  property name and written value
+     *  @param[in]  success   -  the write succeeded
+     */
+    void updatePhysicalState(
+        const std::string& objPath,
+        const std::pair<std::string, PropertyValue>& property, bool success);
+
+    /** @brief Finishes a request once all its Set calls are replied, queueing
+     *         it for retry if one of them failed.
+     *
+     *  @param[in]  iter  -  request in pendingLeds
+     */
+    void completeRequest(std::map<uint64_t, PendingLed>::iterator iter);
+
+    /** @brief Updates the asserted state and the LED reference counts of a
+     *         group
+     *
+     *  @param[in]  id      -  group id
+     *  @param[in]  assert  -  Could be true or false
+     *  @param[in]  before  -  records the state of the LEDs not in it yet
+     */
+    void updateGroup(Layout::NameId id, bool assert, LedSnapshot& before);
+
+    /** @brief Finds the LEDs whose action differs from a snapshot
+     *
+     *  @param[in]  before        -  state of the LEDs before the changes
+     *  @param[in]  ledsAssert    -  LEDs that are to be asserted new
+     *                               or to a different state
+     *  @param[in]  ledsDeAssert  -  LEDs that are to be Deasserted
+     */
+    void diffLeds(const LedSnapshot& before, group& ledsAssert,
+                  group& ledsDeAssert) const;
+
+    /** @brief Returns the id of a group
+     *
+     *  @param[in]  path  -  dbus path of group
+     *
+     *  @return           -  group id, std::out_of_range thrown if unknown
+     */
+    Layout::NameId groupId(const std::string& path) const;
+
+    /** @brief Materializes the named LED action of a member
+     *
+     *  @param[in]  member  -  group member
+     *
+     *  @return             -  LED action carrying the LED name
+     */
+    Layout::LedAction toLedAction(const Layout::Member& member) const;
+
     /** @brief Returns action string based on enum
      *
      *  @param[in]  action - Action enum
@@ -4,6 +4,60 @@ import os
 import argparse
 from inflection import underscore
 
+
+def name_hash(name, seed):
+    # Same as Layout::nameHash(), FNV-1a with a seed
+    value = 2166136261 ^ seed
+    for byte in name.encode():
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def perfect_hash(names):
+    # Hash and displace: names are spread over buckets with seed 0, then a
+    # seed is searched for every bucket, largest first, placing all its
+    # names in free slots. The table grows when a bucket can't be placed.
+    # Layout::buildPerfectHash() builds the same tables at runtime.
+    if not names:
+        return [], []
+
+    ids = {name: id for id, name in enumerate(names)}
+    bucket_count = (len(names) + 3) // 4
+    buckets = [[] for _ in range(bucket_count)]
+    for name in names:
+        buckets[name_hash(name, 0) % bucket_count].append(name)
+    order = sorted(range(bucket_count), key=lambda b: -len(buckets[b]))
+
+    slot_count = len(names)
+    while True:
+        seeds = [0] * bucket_count
+        slots = [None] * slot_count
+        for bucket in order:
+            for seed in range(1, 1 << 16):
+                placed = [name_hash(name, seed) % slot_count
+                          for name in buckets[bucket]]
+                if len(set(placed)) == len(placed) and \
+                        all(slots[slot] is None for slot in placed):
+                    break
+            else:
+                break
+            seeds[bucket] = seed
+            for name, slot in zip(buckets[bucket], placed):
+                slots[slot] = ids[name]
+        else:
+            return seeds, [slot or 0 for slot in slots]
+        slot_count += len(names) // 8 + 1
+
+
+def write_array(ofile, type, name, values):
+    ofile.write('static constexpr std::array<' + type + ', ' +
+                str(len(values)) + '> ' + name + ' = {{\n')
+    for value in values:
+        ofile.write('    ' + value + ',\n')
+    ofile.write('}};\n\n')
+
+
 if __name__ == '__main__':
     script_dir = os.path.dirname(os.path.realpath(__file__))
     parser = argparse.ArgumentParser()
@@ -40,49 +94,83 @@ if __name__ == '__main__':
     # Dictionary having [Name:Priority]
     priority_dict = {}
 
+    # Map of group D-Bus path to its members, sorted by LED name
+    groups = {}
+    for group in list(ifile.keys()):
+        led_dict = ifile[group]
+        members = []
+
+        # Some LED groups could be empty
+        for led_name, list_dict in list((led_dict or {}).items()):
+            value = list_dict.get('Priority')
+            if led_name in priority_dict:
+                if value != priority_dict[led_name]:
+                    # Priority for a particular LED needs to stay SAME
+                    # across all groups
+                    raise ValueError("Priority for [" +
+                                     led_name +
+                                     "] is NOT same across all groups")
+            else:
+                priority_dict[led_name] = value
+
+            members.append((underscore(led_name),
+                            str(list_dict.get('Action', 'Off')),
+                            str(list_dict.get('DutyOn', 50)),
+                            str(list_dict.get('Period', 0)),
+                            str(list_dict.get('Priority', 'Blink'))))
+
+        path = "/xyz/openbmc_project/led/groups/" + underscore(group)
+        groups[path] = sorted(members)
+
+    # Intern the names the way Layout::CompiledLayout does, groups in path
+    # order and LEDs in order of first appearance.
+    group_paths = sorted(groups.keys())
+    led_names = []
+    led_ids = {}
+    members = []
+    offsets = [0]
+    for path in group_paths:
+        for member in groups[path]:
+            if member[0] not in led_ids:
+                led_ids[member[0]] = len(led_names)
+                led_names.append(member[0])
+            members.append((led_ids[member[0]],) + member[1:])
+        offsets.append(len(members))
+
     with open(os.path.join(args.outputdir, 'led-gen.hpp'), 'w') as ofile:
         ofile.write('/* !!! WARNING: This is a GENERATED Code..')
         ofile.write('Please do NOT Edit !!! */\n\n')
+        ofile.write('#include <array>\n#include <string_view>\n\n')
+
+        write_array(ofile, 'std::string_view', 'systemGroupPaths',
+                    ['"' + path + '"' for path in group_paths])
+        write_array(ofile, 'std::string_view', 'systemLedNames',
+                    ['"' + name + '"' for name in led_names])
+        write_array(ofile, 'phosphor::led::Layout::Member', 'systemMembers',
+                    ['{' + str(member[0]) + ',' +
+                     'phosphor::led::Layout::' + member[1] + ',' +
+                     member[2] + ',' + member[3] + ',' +
+                     'phosphor::led::Layout::' + member[4] + '}'
+                     for member in members])
+        write_array(ofile, 'uint32_t', 'systemOffsets',
+                    [str(offset) for offset in offsets])
+
+        group_seeds, group_slots = perfect_hash(group_paths)
+        write_array(ofile, 'uint32_t', 'systemGroupSeeds',
+                    [str(seed) for seed in group_seeds])
+        write_array(ofile, 'phosphor::led::Layout::NameId',
+                    'systemGroupSlots', [str(slot) for slot in group_slots])
+
+        led_seeds, led_slots = perfect_hash(led_names)
+        write_array(ofile, 'uint32_t', 'systemLedSeeds',
+                    [str(seed) for seed in led_seeds])
+        write_array(ofile, 'phosphor::led::Layout::NameId',
+                    'systemLedSlots', [str(slot) for slot in led_slots])
 
-        ofile.write('static const std::map<std::string,')
-        ofile.write(' std::set<phosphor::led::Layout::LedAction>>')
-        ofile.write(' systemLedMap = {\n\n')
-        for group in list(ifile.keys()):
-            # This section generates an std::map of LedGroupNames to std::set
-            # of LEDs containing the name and properties
-            led_dict = ifile[group]
-            ofile.write(
-                '   {\"' +
-                "/xyz/openbmc_project/led/groups/" +
-                underscore(group) +
-                '\",{\n')
-
-            # Some LED groups could be empty
-            if not led_dict:
-                ofile.write('   }},\n')
-                continue
-
-            for led_name, list_dict in list(led_dict.items()):
-                value = list_dict.get('Priority')
-                if led_name in priority_dict:
-                    if value != priority_dict[led_name]:
-                        # Priority for a particular LED needs to stay SAME
-                        # across all groups
-                        ofile.close()
-                        os.remove(ofile.name)
-                        raise ValueError("Priority for [" +
-                                         led_name +
-                                         "] is NOT same across all groups")
-                else:
-                    priority_dict[led_name] = value
-
-                ofile.write('        {\"' + underscore(led_name) + '\",')
-                ofile.write('phosphor::led::Layout::' +
-                            str(list_dict.get('Action', 'Off')) + ',')
-                ofile.write(str(list_dict.get('DutyOn', 50)) + ',')
-                ofile.write(str(list_dict.get('Period', 0)) + ',')
-                priority = str(list_dict.get('Priority', 'Blink'))
-                ofile.write('phosphor::led::Layout::' + priority + ',')
-                ofile.write('},\n')
-            ofile.write('   }},\n')
+        ofile.write('static constexpr phosphor::led::Layout::StaticLayout')
+        ofile.write(' systemLayout = {\n')
+        ofile.write('    systemGroupPaths, systemLedNames, systemMembers,\n')
+        ofile.write('    systemOffsets,\n')
+        ofile.write('    {systemGroupSeeds, systemGroupSlots},\n')
+        ofile.write('    {systemLedSeeds, systemLedSlots},\n')
         ofile.write('};\n')
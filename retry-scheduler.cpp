@@ -0,0 +1,92 @@
+#include "retry-scheduler.hpp"
+
+#include <algorithm>
+
+namespace phosphor
+{
+namespace led
+{
+
+bool RetryScheduler::failed(const std::string& name, Clock::time_point now)
+{
+    auto& led = leds[name];
+    led.deadline.reset();
+
+    if (++led.attempts >= maxAttempts)
+    {
+        if (!led.exhausted)
+        {
+            led.exhausted = true;
+            ++exhaustedCount;
+        }
+        return false;
+    }
+
+    // Double the delay on every consecutive failure, and retry at a random
+    // point of the second half of it.
+    auto delay = initialDelay;
+    for (unsigned i = 1; i < led.attempts && delay < maxDelay; ++i)
+    {
+        delay *= 2;
+    }
+    delay = std::min(delay, maxDelay);
+
+    std::uniform_int_distribution<Clock::rep> distribution(0,
+                                                           delay.count() / 2);
+    delay -= Clock::duration(distribution(jitter));
+
+    led.deadline = now + delay;
+    deadlines.emplace(*led.deadline, name);
+    ++retryCount;
+
+    return true;
+}
+
+void RetryScheduler::reset(const std::string& name)
+{
+    leds.erase(name);
+}
+
+std::vector<std::string> RetryScheduler::expired(Clock::time_point now)
+{
+    std::vector<std::string> names;
+
+    for (dropStale(); !deadlines.empty() && deadlines.top().first <= now;
+         dropStale())
+    {
+        auto name = deadlines.top().second;
+        deadlines.pop();
+
+        leds[name].deadline.reset();
+        names.emplace_back(std::move(name));
+    }
+
+    return names;
+}
+
+std::optional<RetryScheduler::Clock::time_point> RetryScheduler::nextDeadline()
+{
+    dropStale();
+    if (deadlines.empty())
+    {
+        return std::nullopt;
+    }
+    return deadlines.top().first;
+}
+
+void RetryScheduler::dropStale()
+{
+    while (!deadlines.empty())
+    {
+        const auto& [deadline, name] = deadlines.top();
+        auto led = leds.find(name);
+        if (led != leds.end() && led->second.deadline == deadline)
+        {
+            return;
+        }
+        deadlines.pop();
+    }
+}
+
+} // namespace led
+} // namespace phosphor
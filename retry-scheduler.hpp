@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace led
+{
+
+/** @class RetryScheduler
+ *  @brief Schedules the retries of failed physical LED requests.
+ *
+ *  Every LED backs off exponentially on consecutive failures, with a random
+ *  jitter so LEDs failing together don't retry together, until it reaches
+ *  the maximum number of attempts. The deadlines are kept in a min-heap.
+ */
+class RetryScheduler
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /** @brief Retry state of one LED */
+    struct LedRetry
+    {
+        /** @brief Consecutive failed attempts */
+        unsigned attempts{0};
+
+        /** @brief Time of the next retry, if one is scheduled */
+        std::optional<Clock::time_point> deadline;
+
+        /** @brief Retries were given up after too many attempts */
+        bool exhausted{false};
+    };
+
+    RetryScheduler() = delete;
+    ~RetryScheduler() = default;
+    RetryScheduler(const RetryScheduler&) = delete;
+    RetryScheduler& operator=(const RetryScheduler&) = delete;
+    RetryScheduler(RetryScheduler&&) = default;
+    RetryScheduler& operator=(RetryScheduler&&) = default;
+
+    /** @brief Constructs the scheduler
+     *
+     *  @param[in] initialDelay - delay before the first retry
+     *  @param[in] maxDelay     - upper bound of the delay between retries
+     *  @param[in] maxAttempts  - failed attempts after which retries stop
+     *  @param[in] seed         - seed of the jitter
+     */
+    RetryScheduler(Clock::duration initialDelay, Clock::duration maxDelay,
+                   unsigned maxAttempts,
+                   uint32_t seed = std::random_device{}()) :
+        initialDelay(initialDelay),
+        maxDelay(maxDelay), maxAttempts(maxAttempts), jitter(seed)
+    {}
+
+    /** @brief Records a failed attempt of an LED and schedules its retry
+     *
+     *  @param[in] name - LED name
+     *  @param[in] now  - current time
+     *
+     *  @return true if a retry is scheduled, false when retries are
+     *          exhausted
+     */
+    bool failed(const std::string& name, Clock::time_point now);
+
+    /** @brief Forgets an LED, after a successful or newer request
+     *
+     *  @param[in] name - LED name
+     */
+    void reset(const std::string& name);
+
+    /** @brief Returns the LEDs due for a retry, in deadline order
+     *
+     *  @param[in] now - current time
+     */
+    std::vector<std::string> expired(Clock::time_point now);
+
+    /** @brief Time of the earliest scheduled retry, if any */
+    std::optional<Clock::time_point> nextDeadline();
+
+    /** @brief Retry state of the LEDs that failed since their last success
+     */
+    const std::map<std::string, LedRetry>& getLeds() const
+    {
+        return leds;
+    }
+
+    /** @brief Number of retries scheduled so far */
+    uint64_t getRetryCount() const
+    {
+        return retryCount;
+    }
+
+    /** @brief Number of times retries were given up for an LED */
+    uint64_t getExhaustedCount() const
+    {
+        return exhaustedCount;
+    }
+
+  private:
+    using Deadline = std::pair<Clock::time_point, std::string>;
+
+    /** @brief Drops heap entries whose LED was reset or rescheduled */
+    void dropStale();
+
+    Clock::duration initialDelay;
+    Clock::duration maxDelay;
+    unsigned maxAttempts;
+
+    /** @brief Random generator of the jitter */
+    std::mt19937 jitter;
+
+    /** @brief Retry state, keyed by LED name */
+    std::map<std::string, LedRetry> leds;
+
+    /** @brief Min-heap of the retry deadlines */
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>>
+        deadlines;
+
+    uint64_t retryCount{0};
+    uint64_t exhaustedCount{0};
+};
+
+} // namespace led
+} // namespace phosphor
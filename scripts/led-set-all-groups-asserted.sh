@@ -49,19 +49,21 @@ do
    ((index+=1))
 done
 
-# Now, set the LED group to what has been requested
+# Now, set the LED groups to what has been requested, all in one call
 if [ ${#excluded_groups} -eq 0 ]
 then
-    for line in $(busctl tree xyz.openbmc_project.LED.GroupManager | grep -e groups/ | awk -F 'xyz' '{print "/xyz" $2}');
-    do
-        busctl set-property xyz.openbmc_project.LED.GroupManager "$line" xyz.openbmc_project.Led.Group Asserted b "$action";
-    done
+    groups=$(busctl tree xyz.openbmc_project.LED.GroupManager | grep -e groups/ | awk -F 'xyz' '{print "/xyz" $2}')
 else
-    for line in $(busctl tree xyz.openbmc_project.LED.GroupManager | grep -e groups/ | grep -Ev "$excluded_groups" | awk -F 'xyz' '{print "/xyz" $2}');
-    do
-        busctl set-property xyz.openbmc_project.LED.GroupManager "$line" xyz.openbmc_project.Led.Group Asserted b "$action";
-    done
+    groups=$(busctl tree xyz.openbmc_project.LED.GroupManager | grep -e groups/ | grep -Ev "$excluded_groups" | awk -F 'xyz' '{print "/xyz" $2}')
 fi
 
+args=()
+for line in $groups;
+do
+    args+=("$line" "$action")
+done
+
+busctl call xyz.openbmc_project.LED.GroupManager /xyz/openbmc_project/led/groups xyz.openbmc_project.Led.GroupManager SetGroupsAsserted "a{sb}" $((${#args[@]} / 2)) "${args[@]}";
+
 # Return Success
 exit 0
@@ -2,13 +2,25 @@
 
 #include "serialize.hpp"
 
+#include "utils.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cereal/archives/json.hpp>
 #include <cereal/types/set.hpp>
 #include <cereal/types/string.hpp>
 #include <phosphor-logging/lg2.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <sstream>
 
 // Register class version with Cereal
 CEREAL_CLASS_VERSION(phosphor::led::Serialize, CLASS_VERSION)
@@ -19,6 +31,193 @@ namespace led
 {
 
 namespace fs = std::filesystem;
+using phosphor::led::utils::crc32;
+
+namespace
+{
+
+/** @brief Binary archive layout, all integers little endian:
+ *         magic, version, group count, then for each group its length and
+ *         name, and a CRC-32 of all the preceding bytes.
+ */
+constexpr std::array<char, 4> binaryMagic = {'L', 'E', 'D', 'G'};
+constexpr uint16_t binaryVersion = 1;
+constexpr size_t binaryHeaderSize = binaryMagic.size() + 2 + 4;
+constexpr size_t binaryCrcSize = 4;
+
+void putInt(std::string& data, uint32_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint32_t getInt(std::string_view data, size_t offset, size_t bytes)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(data[offset + i]))
+                 << (8 * i);
+    }
+    return value;
+}
+
+std::string encodeBinary(const SavedGroups& groups)
+{
+    std::string data(binaryMagic.begin(), binaryMagic.end());
+    putInt(data, binaryVersion, 2);
+    putInt(data, groups.size(), 4);
+    for (const auto& group : groups)
+    {
+        putInt(data, group.size(), 2);
+        data += group;
+    }
+    putInt(data, crc32(data), binaryCrcSize);
+    return data;
+}
+
+bool isBinary(std::string_view data)
+{
+    return data.size() >= binaryMagic.size() &&
+           std::equal(binaryMagic.begin(), binaryMagic.end(), data.begin());
+}
+
+/** @brief Decodes a binary archive
+ *
+ *  @return false, leaving groups untouched, if the archive is corrupted
+ */
+bool decodeBinary(std::string_view data, SavedGroups& groups)
+{
+    if (data.size() < binaryHeaderSize + binaryCrcSize || !isBinary(data))
+    {
+        return false;
+    }
+
+    auto end = data.size() - binaryCrcSize;
+    if (getInt(data, end, binaryCrcSize) != crc32(data.substr(0, end)) ||
+        getInt(data, binaryMagic.size(), 2) != binaryVersion)
+    {
+        return false;
+    }
+
+    SavedGroups decoded;
+    auto count = getInt(data, binaryMagic.size() + 2, 4);
+    size_t offset = binaryHeaderSize;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (offset + 2 > end)
+        {
+            return false;
+        }
+        auto size = getInt(data, offset, 2);
+        offset += 2;
+        if (offset + size > end)
+        {
+            return false;
+        }
+        decoded.emplace(data.substr(offset, size));
+        offset += size;
+    }
+
+    if (offset != end)
+    {
+        return false;
+    }
+
+    groups = std::move(decoded);
+    return true;
+}
+
+/** @brief Journal record layout, all integers little endian: operation,
+ *         name length and name, and a CRC-32 of the preceding bytes.
+ */
+constexpr char journalAssert = 'A';
+constexpr char journalDeAssert = 'D';
+constexpr size_t journalHeaderSize = 1 + 2;
+
+void encodeRecord(std::string& journal, const std::string& group,
+                  bool asserted)
+{
+    auto start = journal.size();
+    journal.push_back(asserted ? journalAssert : journalDeAssert);
+    putInt(journal, group.size(), 2);
+    journal += group;
+    putInt(journal, crc32(std::string_view(journal).substr(start)),
+           binaryCrcSize);
+}
+
+/** @brief Applies the journal records to the groups, stopping at the first
+ *         torn or corrupted one
+ *
+ *  @param [in]  data    - journal content
+ *  @param [out] groups  - groups the records are applied to
+ *  @param [out] records - number of records applied
+ *
+ *  @return true if the whole journal was applied
+ */
+bool replayRecords(std::string_view data, SavedGroups& groups,
+                   size_t& records)
+{
+    records = 0;
+    while (data.size() >= journalHeaderSize + binaryCrcSize)
+    {
+        auto size = journalHeaderSize + getInt(data, 1, 2);
+        if (data.size() < size + binaryCrcSize ||
+            getInt(data, size, binaryCrcSize) != crc32(data.substr(0, size)) ||
+            (data[0] != journalAssert && data[0] != journalDeAssert))
+        {
+            break;
+        }
+
+        std::string group(data.substr(journalHeaderSize,
+                                      size - journalHeaderSize));
+        if (data[0] == journalAssert)
+        {
+            groups.emplace(std::move(group));
+        }
+        else
+        {
+            groups.erase(group);
+        }
+
+        data.remove_prefix(size + binaryCrcSize);
+        ++records;
+    }
+    return data.empty();
+}
+
+std::string encodeJson(const SavedGroups& groups)
+{
+    std::ostringstream os;
+    {
+        cereal::JSONOutputArchive oarchive(os);
+        oarchive(groups);
+    }
+    return os.str();
+}
+
+/** @brief Writes a whole file to the file descriptor, then syncs it */
+bool writeAll(int fd, std::string_view data)
+{
+    while (!data.empty())
+    {
+        auto written = ::write(fd, data.data(), data.size());
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(written);
+    }
+    return ::fsync(fd) == 0;
+}
+
+} // namespace
 
 bool Serialize::getGroupSavedState(const std::string& objPath) const
 {
@@ -26,21 +225,81 @@ bool Serialize::getGroupSavedState(const std::string& objPath) const
 }
 
 void Serialize::storeGroups(const std::string& group, bool asserted)
+{
+    if (updateGroup(group, asserted))
+    {
+        scheduleFlush();
+    }
+}
+
+void Serialize::storeGroups(const std::map<std::string, bool>& groups)
+{
+    bool changed = false;
+    for (const auto& [group, asserted] : groups)
+    {
+        changed = updateGroup(group, asserted) || changed;
+    }
+
+    if (changed)
+    {
+        scheduleFlush();
+    }
+}
+
+bool Serialize::updateGroup(const std::string& group, bool asserted)
 {
     // If the name of asserted group does not exist in the archive and the
     // Asserted property is true, it is inserted into archive.
     // If the name of asserted group exist in the archive and the Asserted
     // property is false, entry is removed from the archive.
     auto iter = savedGroups.find(group);
-    if (iter != savedGroups.end() && asserted == false)
+    if ((iter != savedGroups.end()) == asserted)
     {
-        savedGroups.erase(iter);
+        return false;
     }
 
-    if (iter == savedGroups.end() && asserted)
+    if (iter != savedGroups.end())
+    {
+        savedGroups.erase(iter);
+    }
+    else
     {
         savedGroups.emplace(group);
     }
+    dirty = true;
+
+    if (journalLimit > 0)
+    {
+        encodeRecord(pendingJournal, group, asserted);
+        ++pendingRecords;
+    }
+    return true;
+}
+
+void Serialize::scheduleFlush()
+{
+    if (!flushTimer)
+    {
+        flush();
+        return;
+    }
+
+    // Every change restarts the quiet period, so a burst of changes is
+    // written once.
+    flushTimer->restartOnce(quietPeriod);
+}
+
+void Serialize::flush()
+{
+    if (flushTimer)
+    {
+        flushTimer->setEnabled(false);
+    }
+
+    if (!dirty)
+    {
+        return;
+    }
 
     auto dir = path.parent_path();
     if (!fs::exists(dir))
@@ -48,30 +307,155 @@ void Serialize::storeGroups(const std::string& group, bool asserted)
         fs::create_directories(dir);
     }
 
-    std::ofstream os(path.c_str(), std::ios::binary);
-    cereal::JSONOutputArchive oarchive(os);
-    oarchive(savedGroups);
+    // Keep dirty set on failure, so the next change tries again
+    if (journalLimit > 0 && journalRecords + pendingRecords <= journalLimit &&
+        appendJournal())
+    {
+        dirty = false;
+        return;
+    }
+
+    if (writeSnapshot())
+    {
+        dirty = false;
+    }
+}
+
+bool Serialize::appendJournal()
+{
+    int fd = ::open(journalPath().c_str(),
+                    O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        lg2::error(
+            "Failed to open journal, FILE_PATH = {PATH}, ERROR = {ERROR}",
+            "PATH", journalPath(), "ERROR", strerror(errno));
+        return false;
+    }
+
+    bool written = writeAll(fd, pendingJournal);
+    int error = errno;
+    ::close(fd);
+
+    if (!written)
+    {
+        // The snapshot written instead makes a torn record harmless
+        lg2::error(
+            "Failed to append journal, FILE_PATH = {PATH}, ERROR = {ERROR}",
+            "PATH", journalPath(), "ERROR", strerror(error));
+        return false;
+    }
+
+    journalRecords += pendingRecords;
+    pendingJournal.clear();
+    pendingRecords = 0;
+    return true;
+}
+
+bool Serialize::writeSnapshot()
+{
+    if (!writeFile(format == Format::binary ? encodeBinary(savedGroups)
+                                            : encodeJson(savedGroups)))
+    {
+        return false;
+    }
+
+    // The snapshot holds every change of the journal. Replaying the journal
+    // over it is harmless, so a crash before the removal loses nothing.
+    std::error_code ec;
+    fs::remove(journalPath(), ec);
+
+    journalRecords = 0;
+    pendingJournal.clear();
+    pendingRecords = 0;
+    return true;
+}
+
+fs::path Serialize::journalPath() const
+{
+    return fs::path(path).concat(".journal");
+}
+
+bool Serialize::writeFile(std::string_view data) const
+{
+    // Replace the archive, so a power loss leaves either the previous or the
+    // new archive in place.
+    if (auto error = utils::writeFileAtomic(path, data))
+    {
+        lg2::error(
+            "Failed to store groups, FILE_PATH = {PATH}, ERROR = {ERROR}",
+            "PATH", path, "ERROR", strerror(error));
+        return false;
+    }
+
+    return true;
 }
 
 void Serialize::restoreGroups()
 {
+    // A left over temporary file is an incomplete write, the archive
+    // itself is untouched.
+    std::error_code ec;
+    fs::remove(fs::path(path).concat(".tmp"), ec);
 
+    restoreSnapshot();
+    replayJournal();
+}
+
+void Serialize::restoreSnapshot()
+{
     if (!fs::exists(path))
     {
         lg2::info("File does not exist, FILE_PATH = {PATH}", "PATH", path);
         return;
     }
 
+    std::ifstream is(path.c_str(), std::ios::in | std::ios::binary);
+    std::string data(std::istreambuf_iterator<char>(is), {});
+
+    // The corrupted archive is kept, to be replaced by the next store.
+    if (isBinary(data))
+    {
+        if (!decodeBinary(data, savedGroups))
+        {
+            lg2::error("Failed to restore groups, corrupted FILE_PATH = {PATH}",
+                       "PATH", path);
+        }
+        return;
+    }
+
     try
     {
-        std::ifstream is(path.c_str(), std::ios::in | std::ios::binary);
-        cereal::JSONInputArchive iarchive(is);
-        iarchive(savedGroups);
+        std::istringstream iss(data);
+        cereal::JSONInputArchive iarchive(iss);
+        SavedGroups groups;
+        iarchive(groups);
+        savedGroups = std::move(groups);
     }
     catch (const cereal::Exception& e)
     {
         lg2::error("Failed to restore groups, ERROR = {ERROR}", "ERROR", e);
-        fs::remove(path);
+    }
+}
+
+void Serialize::replayJournal()
+{
+    if (!fs::exists(journalPath()))
+    {
+        return;
+    }
+
+    std::ifstream is(journalPath().c_str(), std::ios::in | std::ios::binary);
+    std::string data(std::istreambuf_iterator<char>(is), {});
+
+    if (!replayRecords(data, savedGroups, journalRecords))
+    {
+        // Records appended after a torn one would be lost on the next
+        // restore, compact right away.
+        lg2::error(
+            "Torn group journal, FILE_PATH = {PATH}, RECORDS = {RECORDS}",
+            "PATH", journalPath(), "RECORDS", journalRecords);
+        writeSnapshot();
     }
 }
 
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/utility/timer.hpp>
+
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 
 namespace phosphor
 {
@@ -21,18 +28,71 @@ using SavedGroups = std::set<std::string>;
 class Serialize
 {
   public:
-    Serialize(const fs::path& path) : path(path)
+    /** @brief Format of the stored archive. Both are restored. */
+    enum class Format
+    {
+        json,
+        binary
+    };
+
+    /** @brief Constructs a Serialize saving the groups on every change
+     *
+     *  @param [in] path         - the path of file for storing the groups
+     *  @param [in] format       - format of the stored archive
+     *  @param [in] journalLimit - changes appended to a journal before it is
+     *                             compacted into the archive, 0 to rewrite
+     *                             the archive on every save
+     */
+    Serialize(const fs::path& path, Format format = Format::json,
+              size_t journalLimit = 0) :
+        path(path),
+        format(format), journalLimit(journalLimit)
+    {
+        restoreGroups();
+    }
+
+    /** @brief Constructs a write-behind Serialize, saving the groups once
+     *         they have not changed for a quiet period.
+     *
+     *  @param [in] path        - the path of file for storing the groups
+     *  @param [in] event       - sd event handler running the save
+     *  @param [in] quietPeriod - delay since the last change before saving
+     *  @param [in] format      - format of the stored archive
+     *  @param [in] journalLimit - changes appended to a journal before it
+     *                             is compacted into the archive, 0 to
+     *                             rewrite the archive on every save
+     */
+    Serialize(const fs::path& path, const sdeventplus::Event& event,
+              std::chrono::milliseconds quietPeriod,
+              Format format = Format::json, size_t journalLimit = 0) :
+        path(path),
+        format(format), journalLimit(journalLimit), quietPeriod(quietPeriod)
     {
         restoreGroups();
+        flushTimer.emplace(event, [this](auto&) { flush(); });
     }
 
     /** @brief Store asserted group names to SAVED_GROUPS_FILE
+     *
+     *  In write-behind mode the file is only written after the quiet
+     *  period, or by flush().
      *
      *  @param [in] group     - name of the group
      *  @param [in] asserted  - asserted state, true or false
      */
     void storeGroups(const std::string& group, bool asserted);
 
+    /** @brief Store the asserted state of several groups with one write
+     *
+     *  @param [in] groups - asserted state, keyed by name of the group
+     */
+    void storeGroups(const std::map<std::string, bool>& groups);
+
+    /** @brief Write the asserted group names to SAVED_GROUPS_FILE now, if
+     *         they changed since the last write.
+     */
+    void flush();
+
     /** @brief Is the group in asserted state stored in SAVED_GROUPS_FILE
      *
      *  @param [in] objPath - The D-Bus path that hosts LED group
@@ -42,15 +102,83 @@ class Serialize
     bool getGroupSavedState(const std::string& objPath) const;
 
   private:
-    /** @brief restore asserted group names from SAVED_GROUPS_FILE
+    /** @brief Updates the asserted state of a group in savedGroups
+     *
+     *  @return - true: changed, false: already in that state
+     */
+    bool updateGroup(const std::string& group, bool asserted);
+
+    /** @brief Writes the changes now, or after the quiet period */
+    void scheduleFlush();
+
+    /** @brief restore asserted group names from SAVED_GROUPS_FILE, then
+     *         replay its journal
      */
     void restoreGroups();
 
+    /** @brief restore asserted group names from the archive */
+    void restoreSnapshot();
+
+    /** @brief apply the changes of the journal to the restored groups */
+    void replayJournal();
+
+    /** @brief Appends the pending changes to the journal
+     *
+     *  @return - true: appended, false: failed and logged
+     */
+    bool appendJournal();
+
+    /** @brief Rewrites the archive and empties the journal
+     *
+     *  @return - true: written, false: failed and logged
+     */
+    bool writeSnapshot();
+
+    /** @brief the path of the journal of SAVED_GROUPS_FILE */
+    fs::path journalPath() const;
+
+    /** @brief Atomically replaces SAVED_GROUPS_FILE
+     *
+     *  @param [in] data - content of the file
+     *
+     *  @return          - true: written, false: failed and logged
+     */
+    bool writeFile(std::string_view data) const;
+
     /** @brief the set of names of asserted groups */
     SavedGroups savedGroups;
 
     /** @brief the path of file for storing the names of asserted groups */
     fs::path path;
+
+    /** @brief format of the stored archive */
+    Format format;
+
+    /** @brief changes appended to the journal before compacting it, 0 when
+     *         not journaling
+     */
+    size_t journalLimit{0};
+
+    /** @brief records in the journal file */
+    size_t journalRecords{0};
+
+    /** @brief encoded records not appended to the journal yet */
+    std::string pendingJournal;
+
+    /** @brief number of records in pendingJournal */
+    size_t pendingRecords{0};
+
+    /** @brief savedGroups changed since the last write */
+    bool dirty{false};
+
+    /** @brief delay since the last change before a write-behind save */
+    std::chrono::milliseconds quietPeriod{0};
+
+    /** @brief Timer of the write-behind save, unset when saving immediately
+     */
+    std::optional<
+        sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>>
+        flushTimer;
 };
 
 } // namespace led
@@ -241,3 +241,22 @@ static const std::map<std::string, std::set<phosphor::led::Layout::LedAction>>
               phosphor::led::Layout::Blink},
          }},
 };
+
+static const std::map<std::string, std::set<phosphor::led::Layout::LedAction>>
+    threeGroupsWithOneComonLEDDiffTiming = {
+        {"/xyz/openbmc_project/ledmanager/groups/MultipleLedsASet",
+         {
+             {"One", phosphor::led::Layout::Blink, 50, 1000,
+              phosphor::led::Layout::On},
+         }},
+        {"/xyz/openbmc_project/ledmanager/groups/MultipleLedsBSet",
+         {
+             {"One", phosphor::led::Layout::Blink, 30, 500,
+              phosphor::led::Layout::On},
+         }},
+        {"/xyz/openbmc_project/ledmanager/groups/MultipleLedsCSet",
+         {
+             {"One", phosphor::led::Layout::On, 0, 0,
+              phosphor::led::Layout::On},
+         }},
+};
@@ -0,0 +1,92 @@
+#include "layout-cache.hpp"
+#include "led-test-map.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+using namespace phosphor::led;
+
+namespace fs = std::filesystem;
+
+static void compareLayouts(const Layout::CompiledLayout& left,
+                           const Layout::CompiledLayout& right)
+{
+    ASSERT_EQ(left.groupCount(), right.groupCount());
+    ASSERT_EQ(left.ledCount(), right.ledCount());
+
+    for (size_t id = 0; id < left.groupCount(); ++id)
+    {
+        ASSERT_EQ(left.groupPath(id), right.groupPath(id));
+
+        auto leftMembers = left.groupMembers(id);
+        auto rightMembers = right.groupMembers(id);
+        ASSERT_EQ(leftMembers.size(), rightMembers.size());
+        for (size_t i = 0; i < leftMembers.size(); ++i)
+        {
+            ASSERT_EQ(left.ledName(leftMembers[i].led),
+                      right.ledName(rightMembers[i].led));
+            ASSERT_EQ(leftMembers[i].action, rightMembers[i].action);
+            ASSERT_EQ(leftMembers[i].dutyOn, rightMembers[i].dutyOn);
+            ASSERT_EQ(leftMembers[i].period, rightMembers[i].period);
+            ASSERT_EQ(leftMembers[i].priority, rightMembers[i].priority);
+        }
+    }
+}
+
+TEST(LayoutCache, testRoundTrip)
+{
+    Layout::CompiledLayout layout(
+        twoGroupsWithMultipleComonLEDInDifferentStateDiffPriority);
+
+    auto data = Layout::encodeCache(layout, 42);
+    auto decoded = Layout::decodeCache(data, 42);
+    ASSERT_TRUE(decoded);
+    compareLayouts(layout, *decoded);
+
+    // Compiled from another config
+    ASSERT_FALSE(Layout::decodeCache(data, 43));
+}
+
+TEST(LayoutCache, testCorrupted)
+{
+    Layout::CompiledLayout layout(twoGroupsWithOneComonLEDOn);
+    auto data = Layout::encodeCache(layout, 42);
+
+    auto corrupted = data;
+    corrupted[corrupted.size() / 2] ^= 0x01;
+    ASSERT_FALSE(Layout::decodeCache(corrupted, 42));
+
+    ASSERT_FALSE(Layout::decodeCache(data.substr(0, data.size() - 1), 42));
+    ASSERT_FALSE(Layout::decodeCache("", 42));
+}
+
+TEST(LayoutCache, testStoreAndLoad)
+{
+    static constexpr auto& source = "config/led-group-config.json";
+    static constexpr auto& cache = "config/led-layout.cache";
+    static constexpr auto& staleSource = "config/led-layout-source.json";
+
+    fs::remove(cache);
+    ASSERT_FALSE(Layout::loadCache(cache, source));
+
+    Layout::CompiledLayout layout(twoGroupsWithDistinctLEDsOn);
+    ASSERT_TRUE(Layout::storeCache(cache, layout, source));
+
+    auto loaded = Layout::loadCache(cache, source);
+    ASSERT_TRUE(loaded);
+    compareLayouts(layout, *loaded);
+
+    // The cache is stale once the config changes
+    fs::copy_file(source, staleSource, fs::copy_options::overwrite_existing);
+    ASSERT_TRUE(Layout::loadCache(cache, staleSource));
+    {
+        std::ofstream os(staleSource, std::ios::app);
+        os << "\n";
+    }
+    ASSERT_FALSE(Layout::loadCache(cache, staleSource));
+
+    fs::remove(staleSource);
+    fs::remove(cache);
+}
@@ -67,6 +67,12 @@ TEST(loadJsonConfig, testBadPath)
     ASSERT_THROW(loadJsonConfig(jsonPath), std::exception);
 }
 
+TEST(loadJsonConfig, testBadType)
+{
+    static constexpr auto jsonPath = "config/led-group-config-bad-type.json";
+    ASSERT_THROW(loadJsonConfig(jsonPath), std::exception);
+}
+
 TEST(validatePriority, testGoodPriority)
 {
     PriorityMap priorityMap{};
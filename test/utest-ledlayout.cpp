@@ -0,0 +1,200 @@
+#include "led-test-map.hpp"
+#include "ledlayout.hpp"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace phosphor::led;
+
+TEST(NameTable, testIntern)
+{
+    Layout::NameTable table;
+
+    auto heartbeat = table.intern("heartbeat");
+    auto power = table.intern("power");
+
+    ASSERT_EQ(heartbeat, 0);
+    ASSERT_EQ(power, 1);
+    ASSERT_EQ(table.intern("heartbeat"), heartbeat);
+    ASSERT_EQ(table.size(), 2);
+
+    ASSERT_EQ(table.name(heartbeat), "heartbeat");
+    ASSERT_EQ(table.name(power), "power");
+}
+
+TEST(NameTable, testFind)
+{
+    Layout::NameTable table;
+    table.intern("front_id");
+
+    ASSERT_EQ(table.find("front_id"), 0);
+    ASSERT_EQ(table.find("rear_id"), std::nullopt);
+}
+
+TEST(CompiledLayout, testGroupMembers)
+{
+    Layout::CompiledLayout layout(twoGroupsWithOneComonLEDOn);
+
+    ASSERT_EQ(layout.groupCount(), 2);
+    ASSERT_EQ(layout.ledCount(), 5);
+
+    auto groupA = layout.findGroup(
+        "/xyz/openbmc_project/ledmanager/groups/MultipleLedsASet");
+    auto groupB = layout.findGroup(
+        "/xyz/openbmc_project/ledmanager/groups/MultipleLedsBSet");
+    ASSERT_TRUE(groupA);
+    ASSERT_TRUE(groupB);
+    ASSERT_EQ(layout.findGroup("/xyz/openbmc_project/ledmanager/groups/None"),
+              std::nullopt);
+
+    for (const auto& [path, actions] : twoGroupsWithOneComonLEDOn)
+    {
+        auto members = layout.groupMembers(*layout.findGroup(path));
+        ASSERT_EQ(members.size(), actions.size());
+
+        auto member = members.begin();
+        for (const auto& led : actions)
+        {
+            ASSERT_EQ(layout.ledName(member->led), led.name);
+            ASSERT_EQ(member->action, led.action);
+            ASSERT_EQ(member->dutyOn, led.dutyOn);
+            ASSERT_EQ(member->period, led.period);
+            ASSERT_EQ(member->priority, led.priority);
+            ++member;
+        }
+    }
+
+    // The LED common to both groups is stored once
+    auto three = layout.findLed("Three");
+    ASSERT_TRUE(three);
+    ASSERT_EQ(std::count_if(layout.groupMembers(*groupA).begin(),
+                            layout.groupMembers(*groupA).end(),
+                            [&](const auto& m) { return m.led == *three; }),
+              1);
+    ASSERT_EQ(std::count_if(layout.groupMembers(*groupB).begin(),
+                            layout.groupMembers(*groupB).end(),
+                            [&](const auto& m) { return m.led == *three; }),
+              1);
+}
+
+TEST(CompiledLayout, testEmptyGroup)
+{
+    Layout::GroupMap groupMap = {
+        {"/xyz/openbmc_project/led/groups/empty", {}},
+        {"/xyz/openbmc_project/led/groups/power_on",
+         {{"power", Layout::On, 50, 0, Layout::On}}},
+    };
+    Layout::CompiledLayout layout(groupMap);
+
+    ASSERT_EQ(layout.groupCount(), 2);
+
+    auto empty = layout.findGroup("/xyz/openbmc_project/led/groups/empty");
+    auto powerOn = layout.findGroup("/xyz/openbmc_project/led/groups/power_on");
+    ASSERT_TRUE(layout.groupMembers(*empty).empty());
+    ASSERT_EQ(layout.groupMembers(*powerOn).size(), 1);
+}
+
+namespace
+{
+// Tables as generated by parse_led.py
+constexpr std::array<std::string_view, 2> groupPaths = {
+    "/xyz/openbmc_project/led/groups/enclosure_identify",
+    "/xyz/openbmc_project/led/groups/power_on",
+};
+constexpr std::array<std::string_view, 3> ledNames = {"front_id", "rear_id",
+                                                      "power"};
+constexpr std::array<Layout::Member, 3> members = {{
+    {0, Layout::Blink, 50, 1000, Layout::Blink},
+    {1, Layout::Blink, 50, 1000, Layout::Blink},
+    {2, Layout::On, 50, 0, Layout::On},
+}};
+constexpr std::array<uint32_t, 3> offsets = {0, 2, 3};
+constexpr std::array<uint32_t, 1> groupSeeds = {2};
+constexpr std::array<Layout::NameId, 3> groupSlots = {1, 0, 0};
+constexpr std::array<uint32_t, 1> ledSeeds = {4};
+constexpr std::array<Layout::NameId, 3> ledSlots = {0, 1, 2};
+
+constexpr Layout::StaticLayout staticLayout = {
+    groupPaths, ledNames, members, offsets, {groupSeeds, groupSlots},
+    {ledSeeds, ledSlots},
+};
+} // namespace
+
+TEST(CompiledLayout, testStaticLayout)
+{
+    static_assert(staticLayout.groupIndex.find(
+                      "/xyz/openbmc_project/led/groups/power_on",
+                      staticLayout.groupPaths) == 1);
+
+    Layout::CompiledLayout layout(staticLayout);
+
+    ASSERT_EQ(layout.groupCount(), 2);
+    ASSERT_EQ(layout.ledCount(), 3);
+
+    for (Layout::NameId id = 0; id < layout.groupCount(); ++id)
+    {
+        ASSERT_EQ(layout.findGroup(layout.groupPath(id)), id);
+    }
+    for (Layout::NameId id = 0; id < layout.ledCount(); ++id)
+    {
+        ASSERT_EQ(layout.findLed(layout.ledName(id)), id);
+    }
+    ASSERT_EQ(layout.findGroup("/xyz/openbmc_project/led/groups/None"),
+              std::nullopt);
+    ASSERT_EQ(layout.findLed("rear_fault"), std::nullopt);
+
+    auto identify = layout.groupMembers(0);
+    ASSERT_EQ(identify.size(), 2);
+    ASSERT_EQ(layout.ledName(identify[1].led), "rear_id");
+    ASSERT_EQ(layout.groupMembers(1).size(), 1);
+
+    // Copies share the generated tables
+    auto copy = layout;
+    ASSERT_EQ(copy.groupMembers(1).data(), layout.groupMembers(1).data());
+}
+
+TEST(PerfectHash, testSameAsGenerated)
+{
+    std::vector<uint32_t> seeds;
+    std::vector<Layout::NameId> slots;
+
+    Layout::buildPerfectHash(groupPaths, seeds, slots);
+    ASSERT_TRUE(std::ranges::equal(seeds, groupSeeds));
+    ASSERT_TRUE(std::ranges::equal(slots, groupSlots));
+
+    Layout::buildPerfectHash(ledNames, seeds, slots);
+    ASSERT_TRUE(std::ranges::equal(seeds, ledSeeds));
+    ASSERT_TRUE(std::ranges::equal(slots, ledSlots));
+
+    Layout::buildPerfectHash({}, seeds, slots);
+    ASSERT_TRUE(seeds.empty());
+    ASSERT_TRUE(slots.empty());
+}
+
+TEST(PerfectHash, testManyNames)
+{
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        paths.push_back("/xyz/openbmc_project/led/groups/group" +
+                        std::to_string(i));
+    }
+    std::vector<std::string_view> names(paths.begin(), paths.end());
+
+    std::vector<uint32_t> seeds;
+    std::vector<Layout::NameId> slots;
+    Layout::buildPerfectHash(names, seeds, slots);
+
+    Layout::PerfectHash index{seeds, slots};
+    for (size_t id = 0; id < names.size(); ++id)
+    {
+        ASSERT_EQ(index.find(names[id], names), id);
+    }
+    ASSERT_EQ(index.find("/xyz/openbmc_project/led/groups/group1000", names),
+              std::nullopt);
+}
@@ -0,0 +1,77 @@
+#include "retry-scheduler.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace phosphor::led;
+using namespace std::chrono_literals;
+
+using Clock = RetryScheduler::Clock;
+
+/** @brief Fixed seed, so the jitter is reproducible */
+static constexpr uint32_t seed = 42;
+
+TEST(RetryScheduler, testBackoff)
+{
+    RetryScheduler retries(1s, 8s, 10, seed);
+    auto now = Clock::time_point{};
+
+    // The delay doubles up to the maximum, jitter taking at most half of it
+    for (auto delay : {1s, 2s, 4s, 8s, 8s})
+    {
+        ASSERT_TRUE(retries.failed("power", now));
+        auto deadline = retries.nextDeadline();
+        ASSERT_TRUE(deadline.has_value());
+        ASSERT_LE(*deadline - now, delay);
+        ASSERT_GE(*deadline - now, delay / 2);
+    }
+    ASSERT_EQ(retries.getLeds().at("power").attempts, 5);
+    ASSERT_EQ(retries.getRetryCount(), 5);
+}
+
+TEST(RetryScheduler, testExhausted)
+{
+    RetryScheduler retries(1s, 8s, 3, seed);
+    auto now = Clock::time_point{};
+
+    ASSERT_TRUE(retries.failed("power", now));
+    ASSERT_TRUE(retries.failed("power", now));
+    ASSERT_FALSE(retries.failed("power", now));
+    ASSERT_FALSE(retries.failed("power", now));
+
+    ASSERT_FALSE(retries.nextDeadline().has_value());
+    ASSERT_TRUE(retries.getLeds().at("power").exhausted);
+    ASSERT_EQ(retries.getExhaustedCount(), 1);
+    ASSERT_EQ(retries.getRetryCount(), 2);
+
+    // A success or a newer request starts over
+    retries.reset("power");
+    ASSERT_TRUE(retries.getLeds().empty());
+    ASSERT_TRUE(retries.failed("power", now));
+}
+
+TEST(RetryScheduler, testExpired)
+{
+    RetryScheduler retries(1s, 1min, 10, seed);
+    auto now = Clock::time_point{};
+
+    ASSERT_TRUE(retries.failed("fan", now));
+    ASSERT_TRUE(retries.failed("fan", now));
+    ASSERT_TRUE(retries.failed("power", now));
+    ASSERT_TRUE(retries.failed("identify", now + 1s));
+    retries.reset("identify");
+
+    ASSERT_TRUE(retries.expired(now).empty());
+
+    // Reset and rescheduled LEDs don't expire on their stale deadlines
+    auto names = retries.expired(now + 1s);
+    ASSERT_EQ(names, std::vector<std::string>{"power"});
+
+    names = retries.expired(now + 2s);
+    ASSERT_EQ(names, std::vector<std::string>{"fan"});
+
+    ASSERT_FALSE(retries.nextDeadline().has_value());
+    ASSERT_TRUE(retries.expired(now + 1h).empty());
+
+    // Expired LEDs keep their attempts until reset
+    ASSERT_EQ(retries.getLeds().at("fan").attempts, 2);
+}
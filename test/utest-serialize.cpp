@@ -42,3 +42,155 @@ TEST(SerializeTest, testStoreGroups)
     newSerial.storeGroups(enclosureIdentify, false);
     ASSERT_EQ(false, newSerial.getGroupSavedState(enclosureIdentify));
 }
+
+TEST(SerializeTest, testWriteBehind)
+{
+    namespace fs = std::filesystem;
+
+    static constexpr auto& path = "config/led-save-group-write-behind.json";
+    static constexpr auto& powerOn = "/xyz/openbmc_project/led/groups/power_on";
+
+    fs::remove(path);
+
+    auto event = sdeventplus::Event::get_default();
+    Serialize serialize(path, event, std::chrono::seconds(1));
+
+    // Nothing is written before the quiet period expires or a flush
+    serialize.storeGroups(powerOn, true);
+    ASSERT_EQ(true, serialize.getGroupSavedState(powerOn));
+    ASSERT_EQ(false, fs::exists(path));
+
+    serialize.flush();
+    ASSERT_EQ(true, fs::exists(path));
+    ASSERT_EQ(true, Serialize(path).getGroupSavedState(powerOn));
+
+    serialize.storeGroups(powerOn, false);
+    ASSERT_EQ(true, Serialize(path).getGroupSavedState(powerOn));
+
+    serialize.flush();
+    ASSERT_EQ(false, Serialize(path).getGroupSavedState(powerOn));
+
+    fs::remove(path);
+}
+
+TEST(SerializeTest, testBinaryFormat)
+{
+    namespace fs = std::filesystem;
+
+    static constexpr auto& path = "config/led-save-group-binary";
+    static constexpr auto& powerOn = "/xyz/openbmc_project/led/groups/power_on";
+    static constexpr auto& enclosureIdentify =
+        "/xyz/openbmc_project/led/groups/EnclosureIdentify";
+
+    fs::remove(path);
+
+    Serialize serialize(path, Serialize::Format::binary);
+    serialize.storeGroups(powerOn, true);
+    serialize.storeGroups(enclosureIdentify, true);
+    ASSERT_EQ(false, fs::exists(fs::path(path).concat(".tmp")));
+
+    // Restored whatever the configured format is
+    Serialize newSerial(path);
+    ASSERT_EQ(true, newSerial.getGroupSavedState(powerOn));
+    ASSERT_EQ(true, newSerial.getGroupSavedState(enclosureIdentify));
+
+    // A corrupted archive is detected and kept in place
+    {
+        std::fstream fs(path, std::ios::in | std::ios::out | std::ios::binary);
+        fs.seekp(12);
+        fs.put('X');
+    }
+    auto size = fs::file_size(path);
+    Serialize corrupted(path);
+    ASSERT_EQ(false, corrupted.getGroupSavedState(powerOn));
+    ASSERT_EQ(size, fs::file_size(path));
+
+    fs::remove(path);
+}
+
+TEST(SerializeTest, testJournal)
+{
+    namespace fs = std::filesystem;
+
+    static constexpr auto& path = "config/led-save-group-journal";
+    static constexpr auto& journal = "config/led-save-group-journal.journal";
+    static constexpr auto& powerOn = "/xyz/openbmc_project/led/groups/power_on";
+    static constexpr auto& enclosureIdentify =
+        "/xyz/openbmc_project/led/groups/EnclosureIdentify";
+
+    fs::remove(path);
+    fs::remove(journal);
+
+    {
+        Serialize serialize(path, Serialize::Format::binary, 3);
+
+        // Changes are appended to the journal only
+        serialize.storeGroups(powerOn, true);
+        serialize.storeGroups(enclosureIdentify, true);
+        serialize.storeGroups(powerOn, false);
+        ASSERT_EQ(false, fs::exists(path));
+        ASSERT_EQ(true, fs::exists(journal));
+
+        // Restore replays the journal
+        Serialize newSerial(path);
+        ASSERT_EQ(false, newSerial.getGroupSavedState(powerOn));
+        ASSERT_EQ(true, newSerial.getGroupSavedState(enclosureIdentify));
+
+        // Exceeding the limit compacts the journal into the archive
+        serialize.storeGroups(powerOn, true);
+        ASSERT_EQ(true, fs::exists(path));
+        ASSERT_EQ(false, fs::exists(journal));
+
+        serialize.storeGroups(enclosureIdentify, false);
+        ASSERT_EQ(true, fs::exists(journal));
+    }
+
+    // A torn record is dropped, the previous ones are kept
+    {
+        std::ofstream os(journal, std::ios::app | std::ios::binary);
+        os.put('A');
+    }
+    Serialize restored(path);
+    ASSERT_EQ(true, restored.getGroupSavedState(powerOn));
+    ASSERT_EQ(false, restored.getGroupSavedState(enclosureIdentify));
+    ASSERT_EQ(false, fs::exists(journal));
+
+    fs::remove(path);
+}
+
+TEST(SerializeTest, testStoreGroupsBatch)
+{
+    namespace fs = std::filesystem;
+
+    static constexpr auto& path = "config/led-save-group-batch";
+    static constexpr auto& journal = "config/led-save-group-batch.journal";
+    static constexpr auto& powerOn = "/xyz/openbmc_project/led/groups/power_on";
+    static constexpr auto& bmcBooted =
+        "/xyz/openbmc_project/led/groups/bmc_booted";
+    static constexpr auto& enclosureIdentify =
+        "/xyz/openbmc_project/led/groups/EnclosureIdentify";
+
+    fs::remove(path);
+    fs::remove(journal);
+
+    Serialize serialize(path, Serialize::Format::binary, 2);
+
+    // The batch is stored at once, its changes exceed the journal limit
+    serialize.storeGroups(
+        {{powerOn, true}, {bmcBooted, true}, {enclosureIdentify, true}});
+    ASSERT_EQ(true, fs::exists(path));
+    ASSERT_EQ(false, fs::exists(journal));
+
+    Serialize restored(path);
+    ASSERT_EQ(true, restored.getGroupSavedState(powerOn));
+    ASSERT_EQ(true, restored.getGroupSavedState(bmcBooted));
+    ASSERT_EQ(true, restored.getGroupSavedState(enclosureIdentify));
+
+    // Unchanged groups are not stored again
+    serialize.storeGroups({{powerOn, true}, {bmcBooted, false}});
+    ASSERT_EQ(true, fs::exists(journal));
+    ASSERT_EQ(false, Serialize(path).getGroupSavedState(bmcBooted));
+
+    fs::remove(path);
+    fs::remove(journal);
+}
@@ -0,0 +1,60 @@
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace phosphor::led::utils;
+
+static constexpr auto physicalLed = "/xyz/openbmc_project/led/physical/power";
+static constexpr auto physicalIface = "xyz.openbmc_project.Led.Physical";
+static constexpr auto controller = "xyz.openbmc_project.LED.Controller.power";
+
+TEST(ServiceCache, testHitAndMiss)
+{
+    ServiceCache cache;
+
+    ASSERT_EQ(cache.find(physicalLed, physicalIface), nullptr);
+    ASSERT_EQ(cache.misses(), 1);
+    ASSERT_EQ(cache.hits(), 0);
+
+    cache.insert(physicalLed, physicalIface, controller);
+
+    const auto* service = cache.find(physicalLed, physicalIface);
+    ASSERT_NE(service, nullptr);
+    ASSERT_EQ(*service, controller);
+    ASSERT_EQ(cache.misses(), 1);
+    ASSERT_EQ(cache.hits(), 1);
+
+    // Same path with another interface is a different entry
+    ASSERT_EQ(cache.find(physicalLed, "org.freedesktop.DBus.Properties"),
+              nullptr);
+    ASSERT_EQ(cache.misses(), 2);
+}
+
+TEST(ServiceCache, testRemoveService)
+{
+    ServiceCache cache;
+    cache.insert(physicalLed, physicalIface, controller);
+    cache.insert("/xyz/openbmc_project/led/physical/identify", physicalIface,
+                 controller);
+    cache.insert("/xyz/openbmc_project/led/groups/power_on",
+                 "xyz.openbmc_project.Led.Group",
+                 "xyz.openbmc_project.LED.GroupManager");
+    ASSERT_EQ(cache.size(), 3);
+
+    cache.removeService(controller);
+    ASSERT_EQ(cache.size(), 1);
+    ASSERT_EQ(cache.find(physicalLed, physicalIface), nullptr);
+}
+
+TEST(ServiceCache, testRemoveInterfaces)
+{
+    ServiceCache cache;
+    cache.insert(physicalLed, physicalIface, controller);
+    cache.insert(physicalLed, "org.freedesktop.DBus.Properties", controller);
+
+    cache.removeInterfaces(physicalLed, {physicalIface});
+    ASSERT_EQ(cache.size(), 1);
+    ASSERT_EQ(cache.find(physicalLed, physicalIface), nullptr);
+    ASSERT_NE(cache.find(physicalLed, "org.freedesktop.DBus.Properties"),
+              nullptr);
+}
@@ -1789,3 +1789,391 @@ TEST_F(LedTest,
         EXPECT_EQ(0, ledsAssert.size());
     }
 }
+
+/** @brief Blink on an LED with unknown state writes all properties */
+TEST_F(LedTest, changedPropertiesUnknownState)
+{
+    auto properties =
+        Manager::getChangedProperties({}, Layout::Blink, 50, 1000);
+
+    ASSERT_EQ(3, properties.size());
+    EXPECT_EQ("DutyOn", properties[0].first);
+    EXPECT_EQ(PropertyValue{uint8_t(50)}, properties[0].second);
+    EXPECT_EQ("Period", properties[1].first);
+    EXPECT_EQ(PropertyValue{uint16_t(1000)}, properties[1].second);
+    EXPECT_EQ("State", properties[2].first);
+    EXPECT_EQ(PropertyValue{std::string(
+                  "xyz.openbmc_project.Led.Physical.Action.Blink")},
+              properties[2].second);
+}
+
+/** @brief Only the properties that differ from the written ones are set */
+TEST_F(LedTest, changedPropertiesSkipWritten)
+{
+    PropertyMap state = {
+        {"DutyOn", uint8_t(50)},
+        {"Period", uint16_t(1000)},
+        {"State", std::string("xyz.openbmc_project.Led.Physical.Action.Off")},
+    };
+
+    // Same blink parameters, only the State changes
+    auto properties =
+        Manager::getChangedProperties(state, Layout::Blink, 50, 1000);
+    ASSERT_EQ(1, properties.size());
+    EXPECT_EQ("State", properties[0].first);
+
+    // A new Period is written before the State
+    properties = Manager::getChangedProperties(state, Layout::Blink, 50, 500);
+    ASSERT_EQ(2, properties.size());
+    EXPECT_EQ("Period", properties[0].first);
+    EXPECT_EQ("State", properties[1].first);
+
+    // Nothing to write when the LED is already Off
+    properties = Manager::getChangedProperties(state, Layout::Off, 0, 0);
+    EXPECT_EQ(0, properties.size());
+}
+
+/** @brief Reloading the layout only drives the LEDs of changed groups */
+TEST_F(LedTest, reloadLayout)
+{
+    Manager manager(bus, twoGroupsWithDistinctLEDsOn);
+    auto groupA = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsASet";
+    auto groupB = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsBSet";
+    {
+        Manager::group ledsAssert{};
+        Manager::group ledsDeAssert{};
+        manager.setGroupState(groupA, true, ledsAssert, ledsDeAssert);
+        manager.setGroupState(groupB, true, ledsAssert, ledsDeAssert);
+    }
+
+    // Set-A keeps its members, Set-B blinks "Four" and drops "Five" and
+    // "Six", and Set-C is added.
+    Layout::GroupMap newLayout = twoGroupsWithDistinctLEDsOn;
+    newLayout[groupB] = {
+        {"Four", phosphor::led::Layout::Blink, 0, 0,
+         phosphor::led::Layout::Blink},
+    };
+    auto groupC = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsCSet";
+    newLayout[groupC] = {
+        {"Seven", phosphor::led::Layout::On, 0, 0, phosphor::led::Layout::On},
+    };
+
+    Manager::group ledsAssert{};
+    Manager::group ledsDeAssert{};
+    manager.reloadLayout(newLayout, ledsAssert, ledsDeAssert);
+
+    EXPECT_EQ(true, manager.isAsserted(groupA));
+    EXPECT_EQ(true, manager.isAsserted(groupB));
+    EXPECT_EQ(false, manager.isAsserted(groupC));
+
+    ASSERT_EQ(1, ledsAssert.size());
+    EXPECT_EQ("Four", ledsAssert.begin()->name);
+    EXPECT_EQ(phosphor::led::Layout::Blink, ledsAssert.begin()->action);
+
+    std::set<std::string> refDeAssert = {"Five", "Six"};
+    std::set<std::string> deAsserted;
+    for (const auto& led : ledsDeAssert)
+    {
+        deAsserted.insert(led.name);
+    }
+    EXPECT_EQ(refDeAssert, deAsserted);
+
+    // Groups removed from the layout are gone
+    manager.reloadLayout(singleLedOn, ledsAssert, ledsDeAssert);
+    EXPECT_THROW(manager.isAsserted(groupA), std::out_of_range);
+}
+
+/** @brief Deasserting the group whose timing an LED blinks with moves it to
+ *         the timing of a group still asserted
+ */
+TEST_F(LedTest, deAssertTimingGroup)
+{
+    Manager manager(bus, threeGroupsWithOneComonLEDDiffTiming);
+    auto groupA = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsASet";
+    auto groupB = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsBSet";
+    auto groupC = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsCSet";
+    {
+        Manager::group ledsAssert{};
+        Manager::group ledsDeAssert{};
+        manager.setGroupState(groupA, true, ledsAssert, ledsDeAssert);
+        manager.setGroupState(groupB, true, ledsAssert, ledsDeAssert);
+        manager.setGroupState(groupC, true, ledsAssert, ledsDeAssert);
+        manager.setGroupState(groupA, false, ledsAssert, ledsDeAssert);
+    }
+
+    // Only Set-B blinks the LED now
+    Manager::group ledsAssert{};
+    Manager::group ledsDeAssert{};
+    manager.setGroupState(groupC, false, ledsAssert, ledsDeAssert);
+
+    std::set<Layout::LedAction> refAssert = {
+        {"One", phosphor::led::Layout::Blink, 30, 500,
+         phosphor::led::Layout::On},
+    };
+    ASSERT_EQ(refAssert.size(), ledsAssert.size());
+    EXPECT_EQ(30, ledsAssert.begin()->dutyOn);
+    EXPECT_EQ(500, ledsAssert.begin()->period);
+    EXPECT_EQ(0, ledsDeAssert.size());
+}
+
+/** @brief Deasserting the group whose timing an LED blinks with drives the
+ *         LED again with the timing of the other blinking group
+ */
+TEST_F(LedTest, deAssertTimingGroupSameAction)
+{
+    Manager manager(bus, threeGroupsWithOneComonLEDDiffTiming);
+    auto groupA = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsASet";
+    auto groupB = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsBSet";
+    {
+        Manager::group ledsAssert{};
+        Manager::group ledsDeAssert{};
+        manager.setGroupState(groupA, true, ledsAssert, ledsDeAssert);
+        manager.setGroupState(groupB, true, ledsAssert, ledsDeAssert);
+    }
+
+    // The LED still blinks, with the DutyOn and Period of Set-B
+    Manager::group ledsAssert{};
+    Manager::group ledsDeAssert{};
+    manager.setGroupState(groupA, false, ledsAssert, ledsDeAssert);
+
+    ASSERT_EQ(1, ledsAssert.size());
+    EXPECT_EQ(phosphor::led::Layout::Blink, ledsAssert.begin()->action);
+    EXPECT_EQ(30, ledsAssert.begin()->dutyOn);
+    EXPECT_EQ(500, ledsAssert.begin()->period);
+    EXPECT_EQ(0, ledsDeAssert.size());
+}
+
+/** @brief A reload changing the group whose timing an LED blinks with keeps
+ *         the LED on the timing of an asserted group
+ */
+TEST_F(LedTest, reloadLayoutTimingGroup)
+{
+    Manager manager(bus, threeGroupsWithOneComonLEDDiffTiming);
+    auto groupA = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsASet";
+    auto groupB = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsBSet";
+    auto groupC = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsCSet";
+    {
+        Manager::group ledsAssert{};
+        Manager::group ledsDeAssert{};
+        manager.setGroupState(groupA, true, ledsAssert, ledsDeAssert);
+        manager.setGroupState(groupB, true, ledsAssert, ledsDeAssert);
+        manager.setGroupState(groupC, true, ledsAssert, ledsDeAssert);
+    }
+
+    // Set-A blinks with a new timing
+    Layout::GroupMap newLayout = threeGroupsWithOneComonLEDDiffTiming;
+    newLayout[groupA] = {
+        {"One", phosphor::led::Layout::Blink, 20, 200,
+         phosphor::led::Layout::On},
+    };
+    {
+        Manager::group ledsAssert{};
+        Manager::group ledsDeAssert{};
+        manager.reloadLayout(newLayout, ledsAssert, ledsDeAssert);
+        manager.setGroupState(groupB, false, ledsAssert, ledsDeAssert);
+    }
+
+    // Only Set-A blinks the LED now
+    Manager::group ledsAssert{};
+    Manager::group ledsDeAssert{};
+    manager.setGroupState(groupC, false, ledsAssert, ledsDeAssert);
+
+    ASSERT_EQ(1, ledsAssert.size());
+    EXPECT_EQ(phosphor::led::Layout::Blink, ledsAssert.begin()->action);
+    EXPECT_EQ(20, ledsAssert.begin()->dutyOn);
+    EXPECT_EQ(200, ledsAssert.begin()->period);
+    EXPECT_EQ(0, ledsDeAssert.size());
+}
+
+/** @brief Swap the asserted group in one batch, the common LED is untouched
+ */
+TEST_F(LedTest, setGroupStatesBatch)
+{
+    Manager manager(bus, twoGroupsWithOneComonLEDOn);
+    auto groupA = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsASet";
+    auto groupB = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsBSet";
+    {
+        Manager::group ledsAssert{};
+        Manager::group ledsDeAssert{};
+        manager.setGroupState(groupA, true, ledsAssert, ledsDeAssert);
+    }
+
+    // An unknown group fails the whole batch
+    Manager::group ledsAssert{};
+    Manager::group ledsDeAssert{};
+    EXPECT_THROW(
+        manager.setGroupStates(
+            {{groupA, false},
+             {"/xyz/openbmc_project/ledmanager/groups/None", true}},
+            ledsAssert, ledsDeAssert),
+        std::out_of_range);
+    EXPECT_EQ(true, manager.isAsserted(groupA));
+    EXPECT_EQ(0, ledsAssert.size());
+    EXPECT_EQ(0, ledsDeAssert.size());
+
+    manager.setGroupStates({{groupA, false}, {groupB, true}}, ledsAssert,
+                           ledsDeAssert);
+    EXPECT_EQ(false, manager.isAsserted(groupA));
+    EXPECT_EQ(true, manager.isAsserted(groupB));
+
+    std::set<std::string> refAssert = {"Four", "Six"};
+    std::set<std::string> asserted;
+    for (const auto& led : ledsAssert)
+    {
+        asserted.insert(led.name);
+    }
+    EXPECT_EQ(refAssert, asserted);
+
+    std::set<std::string> refDeAssert = {"One", "Two"};
+    std::set<std::string> deAsserted;
+    for (const auto& led : ledsDeAssert)
+    {
+        deAsserted.insert(led.name);
+    }
+    EXPECT_EQ(refDeAssert, deAsserted);
+}
+
+/** @brief Queued group changes are driven as one net diff */
+TEST_F(LedTest, queueGroupStateNetDiff)
+{
+    Manager manager(bus, twoGroupsWithOneComonLEDOn);
+    auto groupA = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsASet";
+    auto groupB = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsBSet";
+
+    // Asserted and DeAsserted within the batch, nothing to drive
+    EXPECT_EQ(true, manager.queueGroupState(groupA, true));
+    EXPECT_EQ(true, manager.isAsserted(groupA));
+    EXPECT_EQ(false, manager.queueGroupState(groupA, false));
+    {
+        Manager::group ledsAssert{};
+        Manager::group ledsDeAssert{};
+        manager.takeQueuedLeds(ledsAssert, ledsDeAssert);
+        EXPECT_EQ(0, ledsAssert.size());
+        EXPECT_EQ(0, ledsDeAssert.size());
+    }
+
+    // Both groups in one batch, the common LED is driven once
+    manager.queueGroupState(groupA, true);
+    manager.queueGroupState(groupB, true);
+    {
+        Manager::group ledsAssert{};
+        Manager::group ledsDeAssert{};
+        manager.takeQueuedLeds(ledsAssert, ledsDeAssert);
+
+        std::set<std::string> refAssert = {"One", "Two", "Three", "Four",
+                                           "Six"};
+        std::set<std::string> asserted;
+        for (const auto& led : ledsAssert)
+        {
+            asserted.insert(led.name);
+        }
+        EXPECT_EQ(refAssert.size(), ledsAssert.size());
+        EXPECT_EQ(refAssert, asserted);
+        EXPECT_EQ(0, ledsDeAssert.size());
+    }
+
+    // The batch is empty once taken
+    Manager::group ledsAssert{};
+    Manager::group ledsDeAssert{};
+    manager.takeQueuedLeds(ledsAssert, ledsDeAssert);
+    EXPECT_EQ(0, ledsAssert.size());
+    EXPECT_EQ(0, ledsDeAssert.size());
+}
+
+/** @brief The state reported by the LED services is recorded */
+TEST_F(LedTest, updatePhysicalStates)
+{
+    Manager manager(bus, singleLedOn);
+    auto objPath = std::string(PHY_LED_PATH) + "One";
+
+    manager.updatePhysicalStates(
+        "xyz.openbmc_project.LED.Controller.One", objPath,
+        {{"State", std::string("xyz.openbmc_project.Led.Physical.Action.On")},
+         {"Color", std::string("xyz.openbmc_project.Led.Physical.Palette.Red")},
+         {"DutyOn", uint8_t(50)}});
+    manager.updatePhysicalStates("xyz.openbmc_project.LED.GroupManager",
+                                 "/xyz/openbmc_project/led/groups/One",
+                                 {{"DutyOn", uint8_t(50)}});
+
+    const auto& states = manager.getPhysicalStates();
+    ASSERT_EQ(1, states.size());
+    const auto& state = states.at(objPath);
+    EXPECT_EQ(2, state.size());
+    EXPECT_FALSE(state.contains("Color"));
+
+    // Nothing to write, the LED is already On
+    EXPECT_EQ(0,
+              Manager::getChangedProperties(state, Layout::On, 0, 0).size());
+
+    // Later changes replace the recorded values
+    PropertyMap off = {
+        {"State", std::string("xyz.openbmc_project.Led.Physical.Action.Off")},
+    };
+    manager.updatePhysicalStates("xyz.openbmc_project.LED.Controller.One",
+                                 objPath, off);
+    EXPECT_EQ(1,
+              Manager::getChangedProperties(state, Layout::On, 0, 0).size());
+}
+
+/** @brief The state of an LED whose object or service goes away is
+ *         forgotten, so all its properties are written again
+ */
+TEST_F(LedTest, removePhysicalStates)
+{
+    Manager manager(bus, singleLedOn);
+    auto service = "xyz.openbmc_project.LED.Controller.One";
+    auto objPath = std::string(PHY_LED_PATH) + "One";
+    PropertyMap blinking = {
+        {"State",
+         std::string("xyz.openbmc_project.Led.Physical.Action.Blink")},
+        {"DutyOn", uint8_t(50)},
+        {"Period", uint16_t(1000)},
+    };
+
+    manager.updatePhysicalStates(service, objPath, blinking);
+    const auto& states = manager.getPhysicalStates();
+    ASSERT_EQ(1, states.size());
+    EXPECT_EQ(0, Manager::getChangedProperties(states.at(objPath),
+                                               Layout::Blink, 50, 1000)
+                     .size());
+
+    // The object is removed, driving the LED writes all its properties
+    manager.removePhysicalState(objPath);
+    EXPECT_FALSE(states.contains(objPath));
+    EXPECT_EQ(0, manager.drivePhysicalLED(objPath, Layout::Blink, 50, 1000));
+    EXPECT_EQ(blinking, states.at(objPath));
+
+    // The service restarts, another service keeps its LEDs
+    auto otherPath = std::string(PHY_LED_PATH) + "Two";
+    manager.updatePhysicalStates(service, objPath, blinking);
+    manager.updatePhysicalStates("xyz.openbmc_project.LED.Controller.Two",
+                                 otherPath, blinking);
+    manager.removePhysicalStates(service);
+    EXPECT_FALSE(states.contains(objPath));
+    EXPECT_TRUE(states.contains(otherPath));
+}
+
+/** @brief Restored groups are applied at once */
+TEST_F(LedTest, queueGroupStates)
+{
+    Manager manager(bus, twoGroupsWithOneComonLEDOn);
+    auto groupA = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsASet";
+    auto groupB = "/xyz/openbmc_project/ledmanager/groups/MultipleLedsBSet";
+
+    // An unknown group fails the whole batch
+    EXPECT_THROW(manager.queueGroupStates(
+                     {{groupA, true},
+                      {"/xyz/openbmc_project/ledmanager/groups/None", true}}),
+                 std::out_of_range);
+    EXPECT_EQ(false, manager.isAsserted(groupA));
+
+    manager.queueGroupStates({{groupA, true}, {groupB, true}});
+    EXPECT_EQ(true, manager.isAsserted(groupA));
+    EXPECT_EQ(true, manager.isAsserted(groupB));
+
+    Manager::group ledsAssert{};
+    Manager::group ledsDeAssert{};
+    manager.takeQueuedLeds(ledsAssert, ledsDeAssert);
+    EXPECT_EQ(5, ledsAssert.size());
+    EXPECT_EQ(0, ledsDeAssert.size());
+}
@@ -1,7 +1,14 @@
 #include "utils.hpp"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <phosphor-logging/lg2.hpp>
 
+#include <array>
+#include <cerrno>
+#include <set>
+
 namespace phosphor
 {
 namespace led
@@ -9,10 +16,177 @@ namespace led
 namespace utils
 {
 
+uint32_t crc32(std::string_view data)
+{
+    static const auto table = [] {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < table.size(); ++i)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (auto c : data)
+    {
+        crc = table[(crc ^ static_cast<uint8_t>(c)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+int writeFileAtomic(const std::filesystem::path& path, std::string_view data)
+{
+    auto tmpPath = std::filesystem::path(path).concat(".tmp");
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+    if (fd < 0)
+    {
+        return errno;
+    }
+
+    int error = 0;
+    while (!data.empty() && !error)
+    {
+        auto written = ::write(fd, data.data(), data.size());
+        if (written < 0)
+        {
+            error = errno == EINTR ? 0 : errno;
+            continue;
+        }
+        data.remove_prefix(written);
+    }
+    if (!error && ::fsync(fd) < 0)
+    {
+        error = errno;
+    }
+    ::close(fd);
+
+    if (!error && ::rename(tmpPath.c_str(), path.c_str()) < 0)
+    {
+        error = errno;
+    }
+    if (error)
+    {
+        std::error_code ec;
+        std::filesystem::remove(tmpPath, ec);
+        return error;
+    }
+
+    // Sync the directory, for the rename itself to be durable
+    auto dir = path.has_parent_path() ? path.parent_path()
+                                      : std::filesystem::path(".");
+    int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0)
+    {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+
+    return 0;
+}
+
+const std::string* ServiceCache::find(const std::string& path,
+                                       const std::string& interface)
+{
+    auto iter = services.find({path, interface});
+    if (iter == services.end())
+    {
+        ++missCount;
+        return nullptr;
+    }
+
+    ++hitCount;
+    return &iter->second;
+}
+
+void ServiceCache::insert(const std::string& path, const std::string& interface,
+                          const std::string& service)
+{
+    services.insert_or_assign({path, interface}, service);
+}
+
+void ServiceCache::removeService(const std::string& service)
+{
+    std::erase_if(services, [&service](const auto& item) {
+        return item.second == service;
+    });
+}
+
+void ServiceCache::removeInterfaces(const std::string& path,
+                                    const std::vector<std::string>& interfaces)
+{
+    for (const auto& interface : interfaces)
+    {
+        services.erase({path, interface});
+    }
+}
+
+ServiceCache& DBusHandler::getServiceCache()
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    static ServiceCache cache;
+
+    // A new owner of a service name may not host the same objects
+    static sdbusplus::bus::match_t nameOwnerChanged(
+        getBus(), rules::nameOwnerChanged(), [](sdbusplus::message_t& msg) {
+            std::string name;
+            std::string oldOwner;
+            std::string newOwner;
+            try
+            {
+                msg.read(name, oldOwner, newOwner);
+            }
+            catch (const sdbusplus::exception::exception& e)
+            {
+                lg2::error("Failed to read NameOwnerChanged, ERROR = {ERROR}",
+                           "ERROR", e);
+                return;
+            }
+
+            if (!oldOwner.empty())
+            {
+                cache.removeService(name);
+            }
+        });
+
+    static sdbusplus::bus::match_t interfacesRemoved(
+        getBus(), rules::interfacesRemoved(), [](sdbusplus::message_t& msg) {
+            sdbusplus::message::object_path path;
+            std::vector<std::string> interfaces;
+            try
+            {
+                msg.read(path, interfaces);
+            }
+            catch (const sdbusplus::exception::exception& e)
+            {
+                lg2::error("Failed to read InterfacesRemoved, ERROR = {ERROR}",
+                           "ERROR", e);
+                return;
+            }
+
+            cache.removeInterfaces(path.str, interfaces);
+        });
+
+    return cache;
+}
+
 // Get service name
 const std::string DBusHandler::getService(const std::string& path,
                                           const std::string& interface) const
 {
+    auto& cache = getServiceCache();
+    if (const auto* service = cache.find(path, interface))
+    {
+        return *service;
+    }
 
     using InterfaceList = std::vector<std::string>;
     std::map<std::string, std::vector<std::string>> mapperResponse;
@@ -34,6 +208,7 @@ const std::string DBusHandler::getService(const std::string& path,
     }
 
     // the value here will be the service name
+    cache.insert(path, interface, mapperResponse.cbegin()->first);
     return mapperResponse.cbegin()->first;
 }
 
@@ -106,6 +281,126 @@ void DBusHandler::setProperty(const std::string& objectPath,
     bus.call_noreply(method);
 }
 
+// Set property asynchronously
+sdbusplus::slot_t DBusHandler::setPropertyAsync(
+    const std::string& objectPath, const std::string& interface,
+    const std::string& propertyName, const PropertyValue& value,
+    std::function<void(sdbusplus::message_t&)> callback) const
+{
+    auto& bus = DBusHandler::getBus();
+    auto service = getService(objectPath, interface);
+    if (service.empty())
+    {
+        throw std::runtime_error("No service found for " + objectPath);
+    }
+
+    auto method = bus.new_method_call(service.c_str(), objectPath.c_str(),
+                                      DBUS_PROPERTY_IFACE, "Set");
+    method.append(interface.c_str(), propertyName.c_str(), value);
+
+    return bus.call_async(
+        method, [callback = std::move(callback)](sdbusplus::message_t reply) {
+            callback(reply);
+        });
+}
+
+// Get all the objects of a service
+const ManagedObjects
+    DBusHandler::getManagedObjects(const std::string& service,
+                                   const std::string& objectPath) const
+{
+    ManagedObjects objects;
+
+    auto& bus = DBusHandler::getBus();
+
+    auto method = bus.new_method_call(service.c_str(), objectPath.c_str(),
+                                      DBUS_OBJECT_MANAGER_IFACE,
+                                      "GetManagedObjects");
+    auto reply = bus.call(method);
+    reply.read(objects);
+
+    return objects;
+}
+
+// Get all the objects of a service asynchronously
+sdbusplus::slot_t DBusHandler::getManagedObjectsAsync(
+    const std::string& service, const std::string& objectPath,
+    std::function<void(const ManagedObjects&, int)> callback) const
+{
+    auto& bus = DBusHandler::getBus();
+
+    auto method = bus.new_method_call(service.c_str(), objectPath.c_str(),
+                                      DBUS_OBJECT_MANAGER_IFACE,
+                                      "GetManagedObjects");
+
+    return bus.call_async(method, [callback = std::move(callback)](
+                                      sdbusplus::message_t reply) {
+        if (reply.is_method_error())
+        {
+            callback({}, reply.get_errno());
+            return;
+        }
+
+        ManagedObjects objects;
+        try
+        {
+            reply.read(objects);
+        }
+        catch (const sdbusplus::exception::exception&)
+        {
+            callback({}, EBADMSG);
+            return;
+        }
+
+        callback(objects, 0);
+    });
+}
+
+sdbusplus::slot_t DBusHandler::getSubTreeServicesAsync(
+    const std::string& objectPath, const std::string& interface,
+    std::function<void(const std::vector<std::string>&, int)> callback) const
+{
+    auto& bus = DBusHandler::getBus();
+
+    auto method = bus.new_method_call(MAPPER_BUSNAME, MAPPER_OBJ_PATH,
+                                      MAPPER_IFACE, "GetSubTree");
+    method.append(objectPath.c_str());
+    method.append(0); // Depth 0 to search all
+    method.append(std::vector<std::string>({interface.c_str()}));
+
+    return bus.call_async(method, [callback = std::move(callback)](
+                                      sdbusplus::message_t reply) {
+        if (reply.is_method_error())
+        {
+            callback({}, reply.get_errno());
+            return;
+        }
+
+        std::map<std::string, std::map<std::string, std::vector<std::string>>>
+            subTree;
+        try
+        {
+            reply.read(subTree);
+        }
+        catch (const sdbusplus::exception::exception&)
+        {
+            callback({}, EBADMSG);
+            return;
+        }
+
+        std::set<std::string> services;
+        for (const auto& [path, objectServices] : subTree)
+        {
+            for (const auto& [service, interfaces] : objectServices)
+            {
+                services.insert(service);
+            }
+        }
+
+        callback({services.begin(), services.end()}, 0);
+    });
+}
+
 const std::vector<std::string>
     DBusHandler::getSubTreePaths(const std::string& objectPath,
                                  const std::string& interface)
@@ -1,7 +1,11 @@
 #pragma once
 #include <sdbusplus/server.hpp>
 
+#include <filesystem>
+#include <functional>
 #include <map>
+#include <string>
+#include <string_view>
 #include <vector>
 namespace phosphor
 {
@@ -13,6 +17,7 @@ constexpr auto MAPPER_BUSNAME = "xyz.openbmc_project.ObjectMapper";
 constexpr auto MAPPER_OBJ_PATH = "/xyz/openbmc_project/object_mapper";
 constexpr auto MAPPER_IFACE = "xyz.openbmc_project.ObjectMapper";
 constexpr auto DBUS_PROPERTY_IFACE = "org.freedesktop.DBus.Properties";
+constexpr auto DBUS_OBJECT_MANAGER_IFACE = "org.freedesktop.DBus.ObjectManager";
 
 using AssociationTuple = std::tuple<std::string, std::string, std::string>;
 using AssociationsProperty = std::vector<AssociationTuple>;
@@ -31,6 +36,101 @@ using DbusProperty = std::string;
 // The Map to constructs all properties values of the interface
 using PropertyMap = std::map<DbusProperty, PropertyValue>;
 
+// The interfaces and properties of the objects of a service, as returned by
+// the ObjectManager GetManagedObjects method
+using ManagedObjects =
+    std::map<sdbusplus::message::object_path,
+             std::map<std::string, PropertyMap>>;
+
+/** @brief CRC-32 (IEEE 802.3) of a buffer, used to check stored files
+ *
+ *  @param[in] data - buffer
+ *
+ *  @return CRC-32 of the buffer
+ */
+uint32_t crc32(std::string_view data);
+
+/** @brief Replaces the content of a file, so that a power loss leaves
+ *         either the previous or the new content in place. The data is
+ *         written and synced to a temporary file renamed over the file, and
+ *         the directory is synced.
+ *
+ *  @param[in] path - path of the file
+ *  @param[in] data - new content of the file
+ *
+ *  @return 0 on success, the errno of the failure otherwise
+ */
+int writeFileAtomic(const std::filesystem::path& path, std::string_view data);
+
+/**
+ *  @class ServiceCache
+ *
+ *  Cache of the D-Bus service hosting an interface on an object path, as
+ *  returned by the ObjectMapper GetObject method.
+ */
+class ServiceCache
+{
+  public:
+    /** @brief Look up the service of an object path and interface
+     *
+     *  @param[in] path      -  D-Bus object path
+     *  @param[in] interface -  D-Bus Interface
+     *
+     *  @return the service name, nullptr when it is not cached
+     */
+    const std::string* find(const std::string& path,
+                            const std::string& interface);
+
+    /** @brief Add the service of an object path and interface
+     *
+     *  @param[in] path      -  D-Bus object path
+     *  @param[in] interface -  D-Bus Interface
+     *  @param[in] service   -  D-Bus service name
+     */
+    void insert(const std::string& path, const std::string& interface,
+                const std::string& service);
+
+    /** @brief Drop every entry hosted by a service, used when the owner of
+     *         the service name changes.
+     *
+     *  @param[in] service   -  D-Bus service name
+     */
+    void removeService(const std::string& service);
+
+    /** @brief Drop the entries of interfaces removed from an object path
+     *
+     *  @param[in] path       -  D-Bus object path
+     *  @param[in] interfaces -  D-Bus Interfaces
+     */
+    void removeInterfaces(const std::string& path,
+                          const std::vector<std::string>& interfaces);
+
+    /** @brief Number of lookups answered from the cache */
+    uint64_t hits() const
+    {
+        return hitCount;
+    }
+
+    /** @brief Number of lookups that needed a mapper call */
+    uint64_t misses() const
+    {
+        return missCount;
+    }
+
+    /** @brief Number of cached entries */
+    size_t size() const
+    {
+        return services.size();
+    }
+
+  private:
+    /** @brief Map of object path and interface to service name */
+    std::map<std::pair<std::string, std::string>, std::string> services;
+
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+};
+
 /**
  *  @class DBusHandler
  *
@@ -48,9 +148,19 @@ class DBusHandler
         return bus;
     }
 
+    /** @brief Get the service cache shared by all the DBusHandler objects.
+     *
+     *  Entries are dropped when the owner of their service changes or when
+     *  their interface is removed from the object path.
+     */
+    static ServiceCache& getServiceCache();
+
     /**
      *  @brief Get service name by the path and interface of the DBus.
      *
+     *  The service is looked up in the service cache first, the mapper is
+     *  only called on a miss.
+     *
      *  @param[in] path      -  D-Bus object path
      *  @param[in] interface -  D-Bus Interface
      *
@@ -100,6 +210,76 @@ class DBusHandler
                      const std::string& propertyName,
                      const PropertyValue& value) const;
 
+    /** @brief Set D-Bus property without waiting for the reply
+     *
+     *  @param[in] objectPath       -   D-Bus object path
+     *  @param[in] interface        -   D-Bus interface
+     *  @param[in] propertyName     -   D-Bus property name
+     *  @param[in] value            -   The value to be set
+     *  @param[in] callback         -   Called with the reply message, which
+     *                                  is a method error if the Set failed
+     *
+     *  @return slot of the pending call, the call is cancelled when the slot
+     *          is destroyed before the reply arrives
+     *
+     *  @throw sdbusplus::exception::exception or std::runtime_error when
+     *         the call can not be sent
+     */
+    [[nodiscard]] sdbusplus::slot_t setPropertyAsync(
+        const std::string& objectPath, const std::string& interface,
+        const std::string& propertyName, const PropertyValue& value,
+        std::function<void(sdbusplus::message_t&)> callback) const;
+
+    /** @brief Get the interfaces and properties of all the objects of a
+     *         service, with one ObjectManager call.
+     *
+     *  @param[in]  service     -  D-Bus service name
+     *  @param[in]  objectPath  -  path of the ObjectManager of the service
+     *
+     *  @return the objects of the service
+     *
+     *  @throw sdbusplus::exception::exception when it fails
+     */
+    const ManagedObjects getManagedObjects(const std::string& service,
+                                           const std::string& objectPath) const;
+
+    /** @brief Get the interfaces and properties of all the objects of a
+     *         service without waiting for the reply
+     *
+     *  @param[in]  service     -  D-Bus service name
+     *  @param[in]  objectPath  -  path of the ObjectManager of the service
+     *  @param[in]  callback    -  Called with the objects of the service,
+     *                             or with the errno of the failed call
+     *
+     *  @return slot of the pending call, the call is cancelled when the slot
+     *          is destroyed before the reply arrives
+     *
+     *  @throw sdbusplus::exception::exception when the call can not be sent
+     */
+    [[nodiscard]] sdbusplus::slot_t getManagedObjectsAsync(
+        const std::string& service, const std::string& objectPath,
+        std::function<void(const ManagedObjects& objects, int error)>
+            callback) const;
+
+    /** @brief Get the services hosting an interface under a path of the
+     *         DBus without waiting for the reply
+     *
+     *  @param[in]  objectPath   -  D-Bus object path
+     *  @param[in]  interface    -  D-Bus object interface
+     *  @param[in]  callback     -  Called with the service names, or with
+     *                              the errno of the failed call
+     *
+     *  @return slot of the pending call, the call is cancelled when the slot
+     *          is destroyed before the reply arrives
+     *
+     *  @throw sdbusplus::exception::exception when the call can not be sent
+     */
+    [[nodiscard]] sdbusplus::slot_t getSubTreeServicesAsync(
+        const std::string& objectPath, const std::string& interface,
+        std::function<void(const std::vector<std::string>& services,
+                           int error)>
+            callback) const;
+
     /** @brief Get sub tree paths by the path and interface of the DBus.
      *
      *  @param[in]  objectPath   -  D-Bus object path